@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <libdragon.h>
+#include <t3d/t3d.h>
+#include <t3d/t3dmodel.h>
+#include <t3d/t3danim.h>
+
+constexpr int ANIM_CLIP_LIBRARY_MAX_RIGS = 8;
+constexpr int ANIM_CLIP_LIBRARY_MAX_SOURCES = 4;
+constexpr int ANIM_CLIP_PATH_LENGTH = 64;
+
+using TAnimRig = int;
+constexpr TAnimRig ANIM_RIG_INVALID = -1;
+
+struct SAnimClipLibraryStats
+{
+    uint32_t rigs{0};
+    uint32_t sources{0};
+    uint32_t hits{0};
+    uint32_t misses{0};
+    uint32_t cursors{0};
+};
+
+class CAnimClipLibrary
+{
+public:
+    static CAnimClipLibrary& instance();
+
+    static uint32_t computeRigHash(const T3DModel* model);
+
+    TAnimRig acquireRig(const T3DModel* model, const char* path);
+    void releaseRig(TAnimRig rig, const T3DModel* model);
+
+    T3DAnim createCursor(TAnimRig rig, const char* name, const T3DModel* fallback);
+    void destroyCursor(TAnimRig rig, T3DAnim& anim);
+
+    bool isValidRig(TAnimRig rig) const { return rig >= 0 && rig < ANIM_CLIP_LIBRARY_MAX_RIGS && mRigs[rig].sourceCount > 0; }
+    SAnimClipLibraryStats const& getStats() const { return mStats; }
+
+private:
+    CAnimClipLibrary() = default;
+
+    // a model that shares the rig's skeleton; the library only holds its own cache reference
+    // while cursors still play clips from it after every owner has released the rig
+    struct SSource
+    {
+        const T3DModel* model{nullptr};
+        char path[ANIM_CLIP_PATH_LENGTH]{};
+        int owners{0};
+        int cursors{0};
+        bool retained{false};
+    };
+
+    struct SRig
+    {
+        SSource sources[ANIM_CLIP_LIBRARY_MAX_SOURCES]{};
+        int sourceCount{0};
+        uint32_t hash{0};
+    };
+
+    TAnimRig findRig(uint32_t hash) const;
+    TAnimRig findFreeRig() const;
+    SSource* findSource(SRig& rig, const T3DModel* model);
+    void updateSource(SRig& rig, SSource& source);
+
+    SRig mRigs[ANIM_CLIP_LIBRARY_MAX_RIGS]{};
+    SAnimClipLibraryStats mStats{};
+};
@@ -1,9 +1,12 @@
 #pragma once
 
-#include <string>
-#include <unordered_map>
 #include "skinned_model.hpp"
 
+constexpr int ANIM_CONTROLLER_BASE_LAYER = 0;
+constexpr int ANIM_CONTROLLER_MOVEMENT_LAYER = 1;
+constexpr int ANIM_CONTROLLER_ACTION_LAYER = 2;
+constexpr int ANIM_CONTROLLER_LAYER_COUNT = 3;
+
 struct AnimationConfig {
     bool loops = true;
     float speed = 1.0f;
@@ -15,32 +18,39 @@ public:
     ~CAnimController() = default;
 
     void init(CSkinnedModel* model);
-    void setBaseAnimation(const std::string& name, const AnimationConfig& config = {});
-    void setMovementAnimation(const std::string& name, const AnimationConfig& config = {});
-    void registerAction(const std::string& name, const AnimationConfig& config = {});
+    void setBaseAnimation(TAnimHandle anim, const AnimationConfig& config = {});
+    void setMovementAnimation(TAnimHandle anim, const AnimationConfig& config = {});
+    void registerAction(TAnimHandle anim, const AnimationConfig& config = {});
     void setBlendFactor(float blend) { mTargetBlend = blend; }
     void forceBlendFactor(float blend) { mTargetBlend = blend; mCurrentBlend = blend; }
     void setMovementSpeed(float speed);
-    void playAction(const std::string& name);
-    void playActionSeamless(const std::string& name);
+    void playAction(TAnimHandle anim);
+    void playActionSeamless(TAnimHandle anim);
     void holdAction(bool hold) { mActionHold = hold; }
     void stopAction();
+    void setActionMask(const char* rootBone);
+    void clearActionMask();
     bool isActionFinished() const;
     void update(float dt);
     bool isActionPlaying() const { return mActionActive || mActionWeight > 0.0f; }
     float getBlendFactor() const { return mCurrentBlend; }
 
 private:
+    void applyPendingMask();
+
     CSkinnedModel* mModel = nullptr;
 
-    std::string mBaseAnim;
-    std::string mMovementAnim;
+    TAnimHandle mBaseAnim = ANIM_HANDLE_INVALID;
+    TAnimHandle mMovementAnim = ANIM_HANDLE_INVALID;
 
     float mCurrentBlend = 0.0f;
     float mTargetBlend = 0.0f;
 
-    std::string mActionAnim;
+    TAnimHandle mActionAnim = ANIM_HANDLE_INVALID;
     bool mActionActive = false;
     bool mActionHold = false;
     float mActionWeight = 0.0f;
+
+    const char* mPendingMaskBone = nullptr;
+    bool mMaskPending = false;
 };
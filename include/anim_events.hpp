@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <libdragon.h>
+
+constexpr int ANIM_EVENT_NAME_LENGTH = 24;
+constexpr int ANIM_EVENT_QUEUE_SIZE = 16;
+
+enum class EAnimEventType : uint8_t
+{
+    Footstep = 0,
+    ThrowRelease,
+    ReelClick,
+    Count
+};
+
+struct SAevtHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t clipCount;
+} __attribute__((packed));
+
+struct SAevtClip {
+    char name[ANIM_EVENT_NAME_LENGTH];
+    uint16_t firstEvent;
+    uint16_t eventCount;
+} __attribute__((packed));
+
+struct SAnimEvent {
+    float time;
+    EAnimEventType type;
+    uint8_t param;
+    uint16_t reserved;
+} __attribute__((packed));
+
+struct SAnimEventRecord
+{
+    int anim{-1};
+    EAnimEventType type{EAnimEventType::Footstep};
+    uint8_t param{0};
+};
+
+class CAnimEventTrackSet
+{
+public:
+    CAnimEventTrackSet() = default;
+    ~CAnimEventTrackSet();
+
+    bool load(const char* path);
+    void unload();
+    bool isLoaded() const { return mClips != nullptr; }
+
+    const SAnimEvent* findTrack(const char* clipName, uint16_t& outCount) const;
+
+private:
+    SAevtClip* mClips{nullptr};
+    SAnimEvent* mEvents{nullptr};
+    uint16_t mClipCount{0};
+    uint16_t mEventCount{0};
+};
+
+class CAnimEventQueue
+{
+public:
+    bool push(SAnimEventRecord const& record);
+    bool pop(SAnimEventRecord& outRecord);
+    void clear() { mHead = 0; mCount = 0; }
+    int getCount() const { return mCount; }
+
+private:
+    SAnimEventRecord mRecords[ANIM_EVENT_QUEUE_SIZE]{};
+    int mHead{0};
+    int mCount{0};
+};
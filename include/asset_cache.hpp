@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <libdragon.h>
+#include <t3d/t3d.h>
+#include <t3d/t3dmodel.h>
+#include "wav64.h"
+
+constexpr int ASSET_CACHE_MAX_ENTRIES = 64;
+constexpr int ASSET_CACHE_PATH_LENGTH = 64;
+constexpr uint32_t ASSET_CACHE_DEFAULT_BUDGET = 512 * 1024;
+
+using TAssetHandle = int;
+constexpr TAssetHandle ASSET_HANDLE_INVALID = -1;
+
+enum class EAssetType : uint8_t
+{
+    Model,
+    Sprite,
+    Sound
+};
+
+struct SAssetCacheStats
+{
+    uint32_t hits{0};
+    uint32_t misses{0};
+    uint32_t evictions{0};
+    uint32_t entries{0};
+    uint32_t bytesResident{0};
+};
+
+class CAssetCache
+{
+public:
+    static CAssetCache& instance();
+
+    static uint32_t hashPath(const char* path);
+
+    TAssetHandle acquire(EAssetType type, const char* path);
+    void release(TAssetHandle handle);
+
+    T3DModel* acquireModel(const char* path) { return getModel(acquire(EAssetType::Model, path)); }
+    sprite_t* acquireSprite(const char* path) { return getSprite(acquire(EAssetType::Sprite, path)); }
+    void releaseData(const void* data);
+
+    T3DModel* getModel(TAssetHandle handle) const;
+    sprite_t* getSprite(TAssetHandle handle) const;
+    wav64_t* getSound(TAssetHandle handle) const;
+
+    void setBudget(uint32_t bytes);
+    uint32_t getBudget() const { return mBudget; }
+    void trim();
+
+    bool isValid(TAssetHandle handle) const { return handle >= 0 && handle < ASSET_CACHE_MAX_ENTRIES && mEntries[handle].data != nullptr; }
+    SAssetCacheStats const& getStats() const { return mStats; }
+
+private:
+    CAssetCache() = default;
+
+    struct SEntry
+    {
+        void* data{nullptr};
+        char path[ASSET_CACHE_PATH_LENGTH]{};
+        uint32_t hash{0};
+        uint32_t bytes{0};
+        uint32_t lastUse{0};
+        int refCount{0};
+        EAssetType type{EAssetType::Model};
+    };
+
+    TAssetHandle find(EAssetType type, uint32_t hash, const char* path) const;
+    TAssetHandle findFree();
+    bool loadEntry(SEntry& entry, EAssetType type, const char* path);
+    void freeEntry(SEntry& entry);
+    void evictToBudget();
+
+    SEntry mEntries[ASSET_CACHE_MAX_ENTRIES]{};
+    uint32_t mUseCounter{0};
+    uint32_t mBudget{ASSET_CACHE_DEFAULT_BUDGET};
+    SAssetCacheStats mStats{};
+};
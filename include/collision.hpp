@@ -20,6 +20,8 @@ constexpr float COL_GRID_CELL_SIZE = 32.0f;
 
 constexpr int COL_MAX_TRIS_PER_CELL = 32;
 
+constexpr float COL_HEIGHT_GRID_CELL_SIZE = 16.0f;
+
 struct ColTriangle {
     int16_t v0[3];
     int16_t v1[3];
@@ -148,3 +150,24 @@ private:
     float mGridOriginX = 0;
     float mGridOriginZ = 0;
 };
+
+class CCollisionHeightGrid {
+public:
+    CCollisionHeightGrid() = default;
+    ~CCollisionHeightGrid();
+    
+    void build(const CCollisionMesh& mesh, float cellSize = COL_HEIGHT_GRID_CELL_SIZE);
+    void clear();
+    bool isBuilt() const { return mHeights != nullptr; }
+    
+    bool sampleHeight(float x, float z, float* outHeight) const;
+
+private:
+    float* mHeights = nullptr;
+    int mWidth = 0;
+    int mHeight = 0;
+    float mOriginX = 0;
+    float mOriginZ = 0;
+    float mCellSize = COL_HEIGHT_GRID_CELL_SIZE;
+    float mInvCellSize = 1.0f / COL_HEIGHT_GRID_CELL_SIZE;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <libdragon.h>
+#include <t3d/t3d.h>
+#include <t3d/t3dmodel.h>
+#include <t3d/t3dskeleton.h>
+#include <t3d/t3danim.h>
+#include "math.hpp"
+#include "anim_clip_library.hpp"
+
+constexpr int CROWD_MAX_ENTRIES = 4;
+constexpr int CROWD_PHASE_SLOTS = 4;
+
+struct SCrowdStats
+{
+    uint32_t instances{0};
+    uint32_t entries{0};
+    uint32_t poses{0};
+    uint32_t poseUpdates{0};
+    uint32_t culled{0};
+};
+
+struct SCrowdHandle
+{
+    int entry{-1};
+    int slot{0};
+
+    bool isValid() const { return entry >= 0; }
+};
+
+class CCrowdPoseCache
+{
+public:
+    CCrowdPoseCache() = default;
+    ~CCrowdPoseCache();
+
+    SCrowdHandle acquire(const char* modelPath, const char* animName);
+    void release(SCrowdHandle handle);
+    void clear();
+
+    void requestPose(SCrowdHandle handle);
+    void markCulled() { ++mStats.culled; }
+    void update(float dt);
+    void draw(SCrowdHandle handle, const T3DMat4FP* matrix);
+
+    float getBoundsRadius(SCrowdHandle handle) const;
+
+    SCrowdStats const& getStats() const { return mStats; }
+    void resetFrameStats() { mStats.poseUpdates = 0; mStats.culled = 0; }
+
+private:
+    struct SPose
+    {
+        T3DSkeleton skeleton{};
+        T3DAnim anim{};
+        float pendingDt{0.0f};
+        bool created{false};
+        bool requested{false};
+    };
+
+    struct SEntry
+    {
+        const char* modelPath{nullptr};
+        const char* animName{nullptr};
+        T3DModel* model{nullptr};
+        TAnimRig rig{ANIM_RIG_INVALID};
+        rspq_block_t* displayList{nullptr};
+        float boundsRadius{0.0f};
+        SPose poses[CROWD_PHASE_SLOTS]{};
+        int nextSlot{0};
+        int refCount{0};
+    };
+
+    int findEntry(const char* modelPath, const char* animName) const;
+    bool createEntry(SEntry& entry, const char* modelPath, const char* animName);
+    void createPose(SEntry& entry, int slot);
+    void destroyEntry(SEntry& entry);
+
+    SEntry mEntries[CROWD_MAX_ENTRIES]{};
+    SCrowdStats mStats{};
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <libdragon.h>
+
+class CLinearArena
+{
+public:
+    CLinearArena() = default;
+    ~CLinearArena();
+
+    bool init(uint32_t capacity, bool uncached = false);
+    void destroy();
+    void reset();
+
+    void* alloc(uint32_t size, uint32_t align = 16);
+
+    template<typename T, typename... TArgs>
+    T* create(TArgs&&... args)
+    {
+        void* mem = alloc(sizeof(T), alignof(T));
+        return mem ? new (mem) T(std::forward<TArgs>(args)...) : nullptr;
+    }
+
+    template<typename T>
+    T* createArray(int count)
+    {
+        T* items = static_cast<T*>(alloc(sizeof(T) * count, alignof(T)));
+        if (!items) return nullptr;
+        for (int i = 0; i < count; ++i) {
+            new (&items[i]) T();
+        }
+        return items;
+    }
+
+    bool isInitialized() const { return mBase != nullptr; }
+    bool contains(const void* ptr) const { return ptr >= mBase && ptr < mBase + mCapacity; }
+    uint32_t getUsed() const { return mUsed; }
+    uint32_t getPeak() const { return mPeak; }
+    uint32_t getCapacity() const { return mCapacity; }
+    void resetPeak() { mPeak = mUsed; }
+
+private:
+    uint8_t* mBase{nullptr};
+    uint32_t mCapacity{0};
+    uint32_t mUsed{0};
+    uint32_t mPeak{0};
+    bool mUncached{false};
+};
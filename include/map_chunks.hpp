@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <libdragon.h>
+#include <t3d/t3d.h>
+#include <t3d/t3dmodel.h>
+#include "math.hpp"
+
+class CViewport;
+
+constexpr int MAP_CHUNK_MAX_CHUNKS = 64;
+
+struct SMapChunk
+{
+    const char* name{nullptr};
+    rspq_block_t* displayList{nullptr};
+    TVec3F aabbMin{0.0f, 0.0f, 0.0f};
+    TVec3F aabbMax{0.0f, 0.0f, 0.0f};
+};
+
+struct SMapChunkStats
+{
+    uint32_t drawn{0};
+    uint32_t frustumCulled{0};
+    uint32_t distanceCulled{0};
+};
+
+class CMapChunkGrid
+{
+public:
+    CMapChunkGrid() = default;
+    ~CMapChunkGrid();
+
+    bool load(const char* path);
+    void unload();
+    void draw(const CViewport* viewport, float drawDistance);
+
+    bool isLoaded() const { return mModel != nullptr; }
+    int getChunkCount() const { return mChunkCount; }
+    SMapChunkStats const& getStats() const { return mStats; }
+
+private:
+    static bool filterChunk(void* userData, const T3DObject* object);
+    SMapChunk* findChunk(const char* name);
+    void buildDisplayLists();
+
+    T3DModel* mModel{nullptr};
+    T3DMat4FP* mMatrixFP{nullptr};
+    SMapChunk mChunks[MAP_CHUNK_MAX_CHUNKS]{};
+    int mChunkCount{0};
+    SMapChunkStats mStats{};
+};
@@ -5,6 +5,9 @@
 #include <t3d/t3d.h>
 #include <t3d/t3dmodel.h>
 #include "math.hpp"
+#include "linear_arena.hpp"
+
+constexpr int MODEL_MATRIX_SEGMENT_ID = 2;
 
 class CModel
 {
@@ -16,9 +19,9 @@ public:
     virtual void unload(); 
     virtual void draw();
     
-    void setPosition(TVec3F const& pos) { mPosition = pos; mDirty = true; }
-    void setRotation(TVec3F const& rot) { mRotation = rot; mDirty = true; }
-    void setScale(TVec3F const& scale) { mScale = scale; mDirty = true; }
+    void setPosition(TVec3F const& pos) { if (pos != mPosition) { mPosition = pos; markDirty(); } }
+    void setRotation(TVec3F const& rot) { if (rot != mRotation) { mRotation = rot; markDirty(); } }
+    void setScale(TVec3F const& scale) { if (scale != mScale) { mScale = scale; markDirty(); } }
     void setColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a);
 
     TVec3F const& getPosition() const { return mPosition; }
@@ -26,12 +29,29 @@ public:
     TVec3F const& getScale() const { return mScale; }
     
     T3DModel* getModel() { return mModel; }
-    T3DMat4FP* getMatrix() { return mMatrixFP; }
+    T3DMat4FP* getMatrix() { return mMatrixFP ? &mMatrixFP[sFrameIndex % mMatrixCount] : nullptr; }
+    bool isDirty() const { return mDirty; }
+
+    void getBoundingSphere(TVec3F& outCenter, float& outRadius) const;
 
     void updateMatrix();
     void buildDisplayList();
 
+    static void drawCallback(void* model) { static_cast<CModel*>(model)->draw(); }
+
+    static uint32_t getMatrixRebuilds() { return sMatrixRebuilds; }
+    static void resetMatrixRebuilds() { sMatrixRebuilds = 0; }
+    static void countMatrixRebuild() { ++sMatrixRebuilds; }
+
+    static void setFrameIndex(uint32_t frameIndex) { sFrameIndex = frameIndex; }
+
+    static void setMatrixArena(CLinearArena* arena) { sMatrixArena = arena; }
+    static T3DMat4FP* allocMatrices(uint32_t count, bool& outInArena);
+    static void freeMatrices(T3DMat4FP*& matrices, bool inArena);
+
 protected:
+    void markDirty() { mDirty = true; mMatrixDirtyMask = ~0u; mBufferDirtyMask = ~0u; }
+
     T3DModel* mModel{nullptr};
     T3DMat4FP* mMatrixFP{nullptr};
     rspq_block_t* mDisplayList{nullptr};
@@ -40,6 +60,17 @@ protected:
     TVec3F mRotation{0.0f, 0.0f, 0.0f};
     TVec3F mScale{1.0f, 1.0f, 1.0f};
     
+    TVec3F mBoundsCenter{0.0f, 0.0f, 0.0f};
+    float mBoundsRadius{0.0f};
+    
     uint8_t mColor[4]{255, 255, 255, 255};
     bool mDirty{true};
+    bool mMatrixInArena{false};
+    uint32_t mMatrixCount{0};
+    uint32_t mMatrixDirtyMask{~0u};
+    uint32_t mBufferDirtyMask{~0u};
+
+    static uint32_t sMatrixRebuilds;
+    static uint32_t sFrameIndex;
+    static CLinearArena* sMatrixArena;
 };
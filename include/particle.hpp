@@ -13,23 +13,74 @@ struct CParticleData
     TVec3F position{0.0f, 0.0f, 0.0f};
     TVec3F velocity{0.0f, 0.0f, 0.0f};
     float size{1.0f};
+    float baseSize{1.0f};
     float life{1.0f};
-    float maxLife{1.0f};
+    float invMaxLife{1.0f};
+    float spawnOffset{0.0f};
     uint8_t color[4]{255, 255, 255, 255};
+    uint8_t baseColor[4]{255, 255, 255, 255};
     bool active{false};
 };
 
+enum class EParticleRenderState
+{
+    Opaque,
+    Alpha,
+    Count
+};
+
+enum class EParticleSpawnShape : uint8_t
+{
+    Point,
+    Sphere,
+    Box
+};
+
+constexpr int PARTICLE_LUT_SIZE = 16;
+
+struct SParticleSpawnParams
+{
+    EParticleSpawnShape shape{EParticleSpawnShape::Point};
+    TVec3F extent{0.0f, 0.0f, 0.0f};
+    TVec3F minVelocity{-1.0f, 1.0f, -1.0f};
+    TVec3F maxVelocity{1.0f, 3.0f, 1.0f};
+    float minSize{1.0f};
+    float maxSize{5.0f};
+    float minLife{1.0f};
+    float maxLife{2.0f};
+    uint8_t color[4]{255, 255, 255, 255};
+};
+
+constexpr int PARTICLE_SYSTEM_MAX_EMITTERS = 16;
+constexpr uint32_t PARTICLE_SYSTEM_BUDGET = 1024;
+constexpr int PARTICLE_LOD_LEVELS = 3;
+constexpr uint32_t PARTICLE_MAX_SIM_SLICES = 8;
+
+class CViewport;
+class CCollisionHeightGrid;
+
+struct SParticleStats
+{
+    uint32_t culled{0};
+    uint32_t simulated{0};
+    uint32_t drawn{0};
+};
+
 class CParticleEmitter
 {
 public:
     CParticleEmitter() = default;
     virtual ~CParticleEmitter();
 
-    void init(uint32_t maxParticles, int matrixStackSize = 8);
+    void init(uint32_t maxParticles);
     void destroy();
 
+    void tick(float dt);
     virtual void update(float dt);
-    virtual void draw();
+    void drawBatched();
+
+    void setFrameIndex(uint32_t frameIndex) { mFrameIndex = frameIndex; }
+    void updateBufferedMatrix(uint32_t frameIndex);
 
     int emit(TVec3F const& position, TVec3F const& velocity, 
              float size, float life,
@@ -40,42 +91,104 @@ public:
                float minSize, float maxSize,
                float minLife, float maxLife,
                uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255);
+    void burst(uint32_t count, TVec3F const& position, SParticleSpawnParams const& params);
 
     void clear();
     void setScale(float scaleX, float scaleY);
     void setPosition(TVec3F const& pos);
     void setGravity(TVec3F const& gravity) { mGravity = gravity; }
-    void setWorldScale(float scale) { mWorldScale = scale; }
-    void setFadeOverLife(bool fade) { mFadeOverLife = fade; }
-    void setShrinkOverLife(bool shrink) { mShrinkOverLife = shrink; }
+    void setWorldScale(float scale) { if (scale != mWorldScale) { mWorldScale = scale; mMatrixDirtyMask = ~0u; } }
+    void setFadeOverLife(bool fade) { mFadeOverLife = fade; if (!mCustomColorLut) buildDefaultColorLut(); }
+    void setShrinkOverLife(bool shrink) { mShrinkOverLife = shrink; if (!mCustomSizeLut) buildDefaultSizeLut(); }
+    void setColorLut(const uint8_t lut[PARTICLE_LUT_SIZE][4]);
+    void setSizeLut(const float lut[PARTICLE_LUT_SIZE]);
+    void setRenderState(EParticleRenderState state) { mRenderState = state; }
+    void setVisible(bool visible) { mVisible = visible; }
+    void setPriority(int priority) { mPriority = priority; }
+    void setParticleLimit(uint32_t limit) { mParticleLimit = limit < mMaxParticles ? limit : mMaxParticles; }
+    void setLodDistances(float nearDist, float farDist) { mLodNear = nearDist; mLodFar = farDist; }
+    void setLodLevel(int level);
+    void setSimulationSlices(uint32_t slices);
+    void setCulled(bool culled) { mCulled = culled; }
 
     uint32_t getActiveCount() const { return mActiveCount; }
     uint32_t getMaxParticles() const { return mMaxParticles; }
+    uint32_t getParticleLimit() const { return mParticleLimit; }
+    uint32_t getDrawCount() const;
+    TVec3F const& getPosition() const { return mPosition; }
+    TVec3F const& getBoundsMin() const { return mBoundsMin; }
+    TVec3F const& getBoundsMax() const { return mBoundsMax; }
+    float getLodNear() const { return mLodNear; }
+    float getLodFar() const { return mLodFar; }
+    int getLodLevel() const { return mLodLevel; }
+    uint32_t getSimulationSlices() const { return mSimSlices; }
+    bool isCulled() const { return mCulled; }
+    bool wasSimulated() const { return mSimulated; }
+    EParticleRenderState getRenderState() const { return mRenderState; }
+    int getPriority() const { return mPriority; }
+    bool isVisible() const { return mVisible; }
     bool isInitialized() const { return mInitialized; }
 
 protected:
     void syncToBuffer();
     int findFreeSlot();
+    void expandBounds(CParticleData const& p);
+    void buildDefaultColorLut();
+    void buildDefaultSizeLut();
+    void spawn(TVec3F const& position, SParticleSpawnParams const& params);
+
+    TPXParticle* getFrameBuffer(uint32_t frameIndex) const {
+        return mParticleBuffers + (frameIndex % mNumBuffers) * (mMaxParticles / 2);
+    }
 
     virtual void onParticleDeath(uint32_t index) {}
+    virtual bool onParticleMove(CParticleData& p) { return true; }
 
-    TPXParticle* mParticleBuffer{nullptr};
+    TPXParticle* mParticleBuffers{nullptr};
     std::vector<CParticleData> mParticles{};
-    T3DMat4FP* mMatrixFP{nullptr};
+    T3DMat4FP* mBufferedMatrices{nullptr};
+    uint32_t mNumBuffers{0};
+    uint32_t mMatrixDirtyMask{~0u};
+    uint32_t mFrameIndex{0};
 
     TVec3F mPosition{0.0f, 0.0f, 0.0f};
     TVec3F mGravity{0.0f, -9.8f, 0.0f};
+    TVec3F mBoundsMin{0.0f, 0.0f, 0.0f};
+    TVec3F mBoundsMax{0.0f, 0.0f, 0.0f};
 
     uint32_t mMaxParticles{0};
+    uint32_t mParticleLimit{0};
     uint32_t mActiveCount{0};
+    int mPriority{0};
+    EParticleRenderState mRenderState{EParticleRenderState::Opaque};
 
     float mScaleX{1.0f};
     float mScaleY{1.0f};
     float mWorldScale{1.0f};
 
+    float mLodNear{200.0f};
+    float mLodFar{400.0f};
+    int mLodLevel{0};
+    float mEmissionScale{1.0f};
+    float mDrawScale{1.0f};
+    uint32_t mSimStride{1};
+    uint32_t mSimCounter{0};
+    float mSimAccumulator{0.0f};
+    uint32_t mSimSlices{1};
+    uint32_t mSliceCursor{0};
+    float mSliceTime[PARTICLE_MAX_SIM_SLICES]{};
+
     bool mInitialized{false};
+    bool mVisible{true};
+    bool mCulled{false};
+    bool mSimulated{false};
     bool mFadeOverLife{true};
     bool mShrinkOverLife{false};
+    bool mCustomColorLut{false};
+    bool mCustomSizeLut{false};
+
+    uint8_t mColorLut[PARTICLE_LUT_SIZE][4]{};
+    float mSizeLut[PARTICLE_LUT_SIZE]{};
 };
 
 class CContinuousEmitter : public CParticleEmitter
@@ -91,23 +204,94 @@ public:
 
     bool isEmitting() const { return mEmitting; }
 
-    void setSpawnVelocity(TVec3F const& min, TVec3F const& max) { mMinVelocity = min; mMaxVelocity = max; }
-    void setSpawnSize(float min, float max) { mMinSize = min; mMaxSize = max; }
-    void setSpawnLife(float min, float max) { mMinLife = min; mMaxLife = max; }
+    void setSpawnVelocity(TVec3F const& min, TVec3F const& max) { mSpawn.minVelocity = min; mSpawn.maxVelocity = max; }
+    void setSpawnSize(float min, float max) { mSpawn.minSize = min; mSpawn.maxSize = max; }
+    void setSpawnLife(float min, float max) { mSpawn.minLife = min; mSpawn.maxLife = max; }
     void setSpawnColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255);
-    void setSpawnSpread(float spread) { mSpawnSpread = spread; }
+    void setSpawnSpread(float spread);
+    void setSpawnShape(EParticleSpawnShape shape, TVec3F const& extent) { mSpawn.shape = shape; mSpawn.extent = extent; }
+    void setSpawnParams(SParticleSpawnParams const& params) { mSpawn = params; }
 
-private:
+protected:
     float mEmissionRate{10.0f};
     float mEmissionAccumulator{0.0f};
     bool mEmitting{false};
 
-    TVec3F mMinVelocity{-1.0f, 1.0f, -1.0f};
-    TVec3F mMaxVelocity{1.0f, 3.0f, 1.0f};
-    float mMinSize{1.0f};
-    float mMaxSize{5.0f};
-    float mMinLife{1.0f};
-    float mMaxLife{2.0f};
-    float mSpawnSpread{0.0f};
-    uint8_t mSpawnColor[4]{255, 255, 255, 255};
-};
\ No newline at end of file
+    SParticleSpawnParams mSpawn{};
+};
+
+class CSnowEmitter : public CContinuousEmitter
+{
+public:
+    CSnowEmitter() = default;
+    ~CSnowEmitter() override = default;
+
+    void setHeightGrid(const CCollisionHeightGrid* grid) { mHeightGrid = grid; }
+    void setSettleTime(float seconds) { mSettleTime = seconds; }
+
+protected:
+    bool onParticleMove(CParticleData& p) override;
+
+private:
+    const CCollisionHeightGrid* mHeightGrid{nullptr};
+    float mSettleTime{0.5f};
+};
+
+class CParticleSystem
+{
+public:
+    static CParticleSystem& instance();
+
+    void init(uint32_t particleBudget = PARTICLE_SYSTEM_BUDGET, int matrixStackSize = 8);
+    void destroy();
+
+    template<typename T>
+    T* createEmitter(uint32_t maxParticles, int priority = 0,
+                     EParticleRenderState state = EParticleRenderState::Opaque)
+    {
+        if (!mInitialized || mEmitterCount >= PARTICLE_SYSTEM_MAX_EMITTERS) {
+            debugf("CParticleSystem: cannot create emitter\n");
+            return nullptr;
+        }
+
+        T* emitter = new T();
+        emitter->init(maxParticles);
+        emitter->setPriority(priority);
+        emitter->setRenderState(state);
+        mEmitters[mEmitterCount++] = emitter;
+
+        allocateBudget();
+        return emitter;
+    }
+
+    void destroyEmitter(CParticleEmitter* emitter);
+
+    void setViewport(CViewport* viewport) { mViewport = viewport; }
+    void setFrameIndex(uint32_t frameIndex);
+    void update(float dt);
+    void updateBufferedMatrix(uint32_t frameIndex);
+    void draw();
+
+    SParticleStats const& getStats() const { return mStats; }
+    uint32_t getBudget() const { return mBudget; }
+    uint32_t getAllocated() const { return mAllocated; }
+    uint32_t getActiveCount() const;
+    bool isInitialized() const { return mInitialized; }
+
+private:
+    CParticleSystem() = default;
+
+    void allocateBudget();
+    void updateVisibility(CParticleEmitter* emitter);
+    static void setupRenderState(EParticleRenderState state);
+    static void drawEmitter(void* userData);
+
+    CParticleEmitter* mEmitters[PARTICLE_SYSTEM_MAX_EMITTERS]{};
+    int mEmitterCount{0};
+    CViewport* mViewport{nullptr};
+    SParticleStats mStats{};
+
+    uint32_t mBudget{0};
+    uint32_t mAllocated{0};
+    bool mInitialized{false};
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <libdragon.h>
+#include "particle.hpp"
+
+constexpr uint16_t PFX_FLAG_CONTINUOUS = 0x0001;
+
+struct SPfxHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t flags;
+    uint16_t maxParticles;
+    uint16_t burstCount;
+    uint8_t spawnShape;
+    uint8_t renderState;
+    uint16_t reserved;
+    float emissionRate;
+    float extent[3];
+    float minVelocity[3];
+    float maxVelocity[3];
+    float gravity[3];
+    float minSize, maxSize;
+    float minLife, maxLife;
+    float worldScale;
+    uint8_t color[4];
+    uint8_t colorLut[PARTICLE_LUT_SIZE][4];
+    uint8_t sizeLut[PARTICLE_LUT_SIZE];
+} __attribute__((packed));
+
+constexpr float PFX_SIZE_LUT_SCALE = 64.0f;
+
+class CParticleEffect
+{
+public:
+    CParticleEffect() = default;
+    ~CParticleEffect() = default;
+
+    bool load(const char* path);
+    bool isLoaded() const { return mLoaded; }
+
+    void configure(CParticleEmitter& emitter) const;
+    void configure(CContinuousEmitter& emitter) const;
+    void burst(CParticleEmitter& emitter, TVec3F const& position) const;
+
+    uint32_t getMaxParticles() const { return mMaxParticles; }
+    uint32_t getBurstCount() const { return mBurstCount; }
+    bool isContinuous() const { return mContinuous; }
+    EParticleRenderState getRenderState() const { return mRenderState; }
+    SParticleSpawnParams const& getSpawnParams() const { return mSpawn; }
+
+private:
+    SParticleSpawnParams mSpawn{};
+    TVec3F mGravity{0.0f, -9.8f, 0.0f};
+    float mEmissionRate{0.0f};
+    float mWorldScale{1.0f};
+    uint32_t mMaxParticles{0};
+    uint32_t mBurstCount{0};
+    EParticleRenderState mRenderState{EParticleRenderState::Opaque};
+    bool mContinuous{false};
+    bool mLoaded{false};
+
+    uint8_t mColorLut[PARTICLE_LUT_SIZE][4]{};
+    float mSizeLut[PARTICLE_LUT_SIZE]{};
+};
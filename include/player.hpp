@@ -9,12 +9,16 @@
 #include "viewport.hpp"
 #include "collision.hpp"
 #include "anim_controller.hpp"
+#include "secondary_motion.hpp"
 #include "player_state.hpp"
 #include "menu.hpp"
 #include "textbox.hpp"
+#include "render_queue.hpp"
 #include <vector>
 
 constexpr int FISHING_LINE_SEGMENTS = 4;
+constexpr int FISHING_LINE_VERT_STRIDE = ((FISHING_LINE_SEGMENTS + 2) / 2) * 2;
+constexpr float FISHING_LINE_VERT_SCALE = 64.0f;
 
 struct SItemGetData
 {
@@ -28,17 +32,49 @@ struct SItemGetData
     int fishIndex;
 };
 
+struct SPlayerAnims
+{
+    TAnimHandle idle{ANIM_HANDLE_INVALID};
+    TAnimHandle walk{ANIM_HANDLE_INVALID};
+    TAnimHandle run{ANIM_HANDLE_INVALID};
+    TAnimHandle prep{ANIM_HANDLE_INVALID};
+    TAnimHandle cast{ANIM_HANDLE_INVALID};
+    TAnimHandle hold{ANIM_HANDLE_INVALID};
+    TAnimHandle reel{ANIM_HANDLE_INVALID};
+};
+
+enum class EPlayerBone : uint8_t
+{
+    Tail0,
+    Tail1,
+    Tail2,
+    Chest,
+    Count
+};
+
+constexpr const char* PLAYER_BONE_NAMES[] = {"tail0", "tail1", "tail2", "chest"};
+constexpr const char* PLAYER_UPPER_BODY_BONE = "spine";
+static_assert(sizeof(PLAYER_BONE_NAMES) / sizeof(PLAYER_BONE_NAMES[0]) == static_cast<int>(EPlayerBone::Count));
+
+enum class ERodBone : uint8_t
+{
+    Root,
+    Pole1,
+    Pole2,
+    Pole3,
+    Count
+};
+
+constexpr const char* ROD_BONE_NAMES[] = {"Root", "Pole_1", "Pole_2", "Pole_3"};
+static_assert(sizeof(ROD_BONE_NAMES) / sizeof(ROD_BONE_NAMES[0]) == static_cast<int>(ERodBone::Count));
+
 class CPlayer final
 {
 public:
     CPlayer() = default;
     ~CPlayer() {
-        delete[] mTailYaw; mTailYaw = nullptr;
-        delete[] mTailPitch; mTailPitch = nullptr;
-        delete[] mTailRoll; mTailRoll = nullptr;
-        delete[] mTailYawVel; mTailYawVel = nullptr;
-        delete[] mTailPitchVel; mTailPitchVel = nullptr;
-        delete[] mTailRollVel; mTailRollVel = nullptr;
+        CSecondaryMotion::instance().removeChain(mTailChain);
+        CSecondaryMotion::instance().removeChain(mRodChain);
     }
 
     void init(TVec3F const& startPos);
@@ -59,10 +95,7 @@ public:
     
     CAnimController& getAnimController() { return mAnimController; }
     CSkinnedModel& getModel() { return mModel; }
-    float getPrevWalkFrame() const { return mPrevWalkFrame; }
-    void setPrevWalkFrame(float frame) { mPrevWalkFrame = frame; }
-    float getPrevRunFrame() const { return mPrevRunFrame; }
-    void setPrevRunFrame(float frame) { mPrevRunFrame = frame; }
+    SPlayerAnims const& getAnims() const { return mAnims; }
     void setSpeedMultiplier(float mult) { mSpeedMultiplier = mult; }
     CPlayerStateMachine& getStateMachine() { return mStateMachine; }
     
@@ -80,6 +113,7 @@ public:
     void setThrowDistance(float dist) { mThrowDistance = dist; }
     
     void startBobberThrow();
+    void resetBobber() { mBobberFlying = false; mBobberLanded = false; }
     void updateBobber(float dt);
     void drawBobber();
     bool isBobberFlying() const { return mBobberFlying; }
@@ -116,19 +150,23 @@ public:
     bool isExpAnimationActive() const { return mExpAnimTimer > 0.0f; }
     bool isLevelUpAnimationActive() const { return mLevelUpAnimTimer > 0.0f; }
 
-    void playFootstepSound(float prevFrame, float currentFrame, float step1Frame, float step2Frame);
+    void playFootstepSound(int foot);
 
 private:
+    static void setupLineState();
+    static void drawLinePacket(void* player);
     void handleInput();
     void updateMovement(float dt);
     void updateAnimations(float dt);
     void clampPosition();
-    void updateTailPhysics(float dt);
+    void updateSecondaryMotion(float dt);
+    void handleAnimationEvents();
     
     void setSkeletonToIdentity(T3DSkeleton* skel);
     void initializeSkinnedModelBuffers(CSkinnedModel& model);
 
     CSkinnedModel mModel{};
+    CAnimEventTrackSet mAnimEvents{};
     CModel mShadow{};
     CSkinnedModel mFishingRod{};
     bool mRodEquipped{false};
@@ -150,8 +188,6 @@ private:
     
     uint32_t mCurrentFrameIndex{0};
     
-    float mPrevWalkFrame{0.0f};
-    float mPrevRunFrame{0.0f};
     float mSpeedMultiplier{1.0f};
     
     bool mIsAttacking{false};
@@ -165,7 +201,6 @@ private:
     float mThrowDistance{15.0f};
     
     CModel mBobber{};
-    int mRodTipBoneIdx{-1};
     TVec3F mBobberPos{0.0f, 0.0f, 0.0f};
     TVec3F mBobberVel{0.0f, 0.0f, 0.0f};
     TVec3F mBobberStart{0.0f, 0.0f, 0.0f};
@@ -176,29 +211,28 @@ private:
     bool mBobberLanded{false};
     
     CAnimController mAnimController{};
+    SPlayerAnims mAnims{};
     
     CPlayerStateMachine mStateMachine{};
 
-    int mTailIdx[4] {-1, -1, -1, -1};
-    float* mTailYaw = nullptr;
-    float* mTailPitch = nullptr;
-    float* mTailRoll = nullptr;
-    float* mTailYawVel = nullptr;
-    float* mTailPitchVel = nullptr;
-    float* mTailRollVel = nullptr;
+    TSecondaryChain mTailChain = SECONDARY_CHAIN_INVALID;
+    TSecondaryChain mRodChain = SECONDARY_CHAIN_INVALID;
     
-    int mChestBoneIdx{-1};
+    int mBones[static_cast<int>(EPlayerBone::Count)]{-1, -1, -1, -1};
+    int mRodBones[static_cast<int>(ERodBone::Count)]{-1, -1, -1, -1};
     float mChestTwist{0.0f};
     float mChestTwistVel{0.0f};
 
-    int mHandBoneIdx{-1};
-    int mRodRootBoneIdx{-1};
+    TSocketHandle mHandSocket{SOCKET_HANDLE_INVALID};
+    TSocketHandle mRodTipSocket{SOCKET_HANDLE_INVALID};
+    T3DMat4 mRodOffset{};
     T3DMat4 mRodWorldMatrix{};
     T3DVec3 mRopePoints[FISHING_LINE_SEGMENTS + 1]{};
     T3DVec3 mRopePrevPoints[FISHING_LINE_SEGMENTS + 1]{};
     bool mRopeInitialized{false};
     
     T3DVertPacked* mLineVerts{nullptr};
+    uint32_t mLineBufferCount{0};
     T3DMat4FP* mLineMatFP{nullptr};
     
     const SItemGetData* mCurrentItem{nullptr};
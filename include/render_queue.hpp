@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <libdragon.h>
+#include "math.hpp"
+
+constexpr int RENDER_QUEUE_MAX_PACKETS = 160;
+
+enum class ERenderState : uint8_t
+{
+    Opaque3D = 0,
+    ParticleOpaque,
+    Impostor,
+    Translucent3D,
+    ParticleAlpha,
+    Line,
+    Count
+};
+
+using TRenderCallback = void (*)(void* userData);
+using TRenderStateSetup = void (*)();
+
+struct SRenderPacket
+{
+    TRenderCallback draw{nullptr};
+    void* userData{nullptr};
+    float depth{0.0f};
+    ERenderState state{ERenderState::Opaque3D};
+    uint16_t order{0};
+};
+
+struct SRenderQueueStats
+{
+    uint32_t packets{0};
+    uint32_t dropped{0};
+    uint32_t stateChanges{0};
+    uint32_t syncs{0};
+};
+
+class CRenderQueue
+{
+public:
+    static CRenderQueue& instance();
+
+    void setStateSetup(ERenderState state, TRenderStateSetup setup) { mSetups[static_cast<int>(state)] = setup; }
+    void setTranslucent(ERenderState state, bool translucent) { mTranslucent[static_cast<int>(state)] = translucent; }
+    void setSorted(bool sorted) { mSorted = sorted; }
+    bool isSorted() const { return mSorted; }
+
+    void begin(TVec3F const& cameraPos);
+    void submit(ERenderState state, TRenderCallback draw, void* userData, float depth = 0.0f);
+    void flush();
+
+    float depthOf(TVec3F const& pos) const;
+
+    SRenderQueueStats const& getStats() const { return mStats; }
+
+private:
+    CRenderQueue();
+
+    void sortPackets(uint16_t* indices, int count, bool backToFront);
+    void applyState(ERenderState state);
+
+    SRenderPacket mPackets[RENDER_QUEUE_MAX_PACKETS]{};
+    uint16_t mOpaque[RENDER_QUEUE_MAX_PACKETS]{};
+    uint16_t mTranslucentOrder[RENDER_QUEUE_MAX_PACKETS]{};
+    int mCount{0};
+
+    TRenderStateSetup mSetups[static_cast<int>(ERenderState::Count)]{};
+    bool mTranslucent[static_cast<int>(ERenderState::Count)]{};
+
+    ERenderState mCurrentState{ERenderState::Opaque3D};
+    bool mSorted{true};
+    TVec3F mCameraPos{0.0f, 0.0f, 0.0f};
+    SRenderQueueStats mStats{};
+    SRenderQueueStats mFrameStats{};
+};
@@ -13,9 +13,56 @@
 #include "light.hpp"
 #include "textbox.hpp"
 #include "shop.hpp"
+#include "crowd.hpp"
+#include "secondary_motion.hpp"
+#include "map_chunks.hpp"
+#include "static_batch.hpp"
+#include "util.hpp"
 
 constexpr int SCENE_MAX_OBJECTS = 32;
+// a preloading scene can coexist with the current one, plus the player's tail and rod
+static_assert(SECONDARY_MOTION_MAX_CHAINS >= SCENE_MAX_OBJECTS * 2 + 2, "secondary motion pool too small for two full scenes");
 constexpr int CUTSCENE_MAX_FRAMES = 64;
+constexpr float SCENE_CULL_BOUNDS_PADDING = 1.25f;
+constexpr float SCENE_FOG_FAR = 150.0f;
+constexpr int SCENE_LOD_MAX_MESHES = 2;
+constexpr uint32_t SCENE_LOAD_BUDGET_US = 6000;
+constexpr int SCENE_LOAD_MAX_ENTRIES = SCENE_MAX_OBJECTS + 3;
+constexpr uint32_t SCENE_ARENA_SIZE = 96 * 1024;
+constexpr uint32_t SCENE_MATRIX_ARENA_SIZE = 16 * 1024;
+constexpr int CUTSCENE_MAX_OBJECTS = 8;
+constexpr uint32_t CUTSCENE_ARENA_SIZE = (sizeof(CModel) + sizeof(CSkinnedModel) + 2 * sizeof(bool)) * CUTSCENE_MAX_OBJECTS + 64;
+// two matrices per object, triple buffered, plus alignment padding
+constexpr uint32_t CUTSCENE_MATRIX_ARENA_SIZE = 4 * 1024;
+constexpr float SCENE_LOD_DEFAULT_HYSTERESIS = 0.1f;
+
+struct SSceneCullStats
+{
+    uint32_t drawn{0};
+    uint32_t culled{0};
+};
+
+struct SSceneLoadEntry
+{
+    const char* name{nullptr};
+    uint32_t us{0};
+};
+
+struct SSceneLoadStats
+{
+    SSceneLoadEntry entries[SCENE_LOAD_MAX_ENTRIES]{};
+    int entryCount{0};
+    uint32_t totalUs{0};
+    uint32_t frames{0};
+};
+
+struct SSceneObjectHandle
+{
+    int index{-1};
+    uint32_t generation{0};
+
+    bool isValid() const { return index >= 0; }
+};
 
 class CScene;
 class CSceneManager;
@@ -104,13 +151,25 @@ struct SCutsceneDef
 
 enum class ESceneObjectType {
     Base,
-    Npc
+    Npc,
+    Crowd
+};
+
+struct SSceneObjectLodDef
+{
+    const char* modelPaths[SCENE_LOD_MAX_MESHES];
+    float distances[SCENE_LOD_MAX_MESHES];
+    const char* impostorPath;
+    float impostorDistance;
+    float impostorHeight;
+    float hysteresis;
 };
 
 struct SSceneObjectDef
 {
     ESceneObjectType type;
     const char* name;
+    uint32_t nameHash;
     const char* modelPath;
     const char* animationName;
     TVec3F position;
@@ -118,6 +177,7 @@ struct SSceneObjectDef
     TVec3F scale;
     float collisionRadius;
     bool hasInteraction;
+    const SSceneObjectLodDef* lod;
 };
 
 class CSceneObject
@@ -134,21 +194,50 @@ public:
     virtual void setFrameIndex(uint32_t frameIndex);
     virtual void updateBufferedMatrix(uint32_t frameIndex);
 
+    virtual void getBounds(TVec3F& outCenter, float& outRadius) const;
+    bool updateVisibility(const CViewport* viewport);
+    bool isVisible() const { return mVisible; }
+
     bool checkPlayerInRange(const TVec3F& playerPos) const;
     void setInteractionCallback(std::function<void(CSceneObject&, CPlayer&)> callback);
     void triggerInteraction(CPlayer& player);
 
     const char* getName() const { return mName; }
+    uint32_t getNameHash() const { return mNameHash; }
     TVec3F getPosition() const { return mPosition; }
     float getCollisionRadius() const { return mCollisionRadius; }
     bool hasInteraction() const { return mHasInteraction; }
     bool isLoaded() const { return mLoaded; }
 
+    void updateLod(const CViewport* viewport);
+    int getLodLevel() const { return mLodLevel; }
+    bool hasLod() const { return mLodDef != nullptr; }
+    bool isImpostor() const { return mImpostor != nullptr && mLodLevel > mLodMeshCount; }
+
+    bool isStaticBatchable() const { return mLoaded && !mIsAnimated && !mHasInteraction && !hasLod() && mModel.getModel() != nullptr; }
+    bool isBatched() const { return mBatched; }
+    void setBatched(bool batched) { mBatched = batched; }
+    const char* getModelPath() const { return mModelPath; }
+
+    static void drawCallback(void* object) { static_cast<CSceneObject*>(object)->draw(); }
+    static void drawImpostorCallback(void* object) { static_cast<CSceneObject*>(object)->drawImpostor(); }
+    static void setupImpostorState();
+    static void setLodArena(CLinearArena* arena) { sLodArena = arena; }
+
     CSkinnedModel* getSkinnedModel() { return mIsAnimated ? &mSkinnedModel : nullptr; }
     CModel* getModel() { return mIsAnimated ? nullptr : &mModel; }
 
 protected:
+    void loadLod(const SSceneObjectDef& def);
+    void unloadLod();
+    void drawImpostor();
+    float getLodThreshold(int level) const;
+    CModel* getActiveModel();
+    CSkinnedModel* getActiveSkinnedModel();
+
     const char* mName = nullptr;
+    uint32_t mNameHash = 0;
+    const char* mModelPath = nullptr;
     TVec3F mPosition{0, 0, 0};
     TVec3F mRotation{0, 0, 0};
     TVec3F mScale{1, 1, 1};
@@ -156,22 +245,34 @@ protected:
     bool mHasInteraction = false;
     bool mLoaded = false;
     bool mIsAnimated = false;
+    bool mVisible = true;
+    bool mBatched = false;
 
     CModel mModel{};
     CSkinnedModel mSkinnedModel{};
+
+    const SSceneObjectLodDef* mLodDef = nullptr;
+    CModel* mLodMeshes[SCENE_LOD_MAX_MESHES]{};
+    bool mLodMeshInArena[SCENE_LOD_MAX_MESHES]{};
+    int mLodMeshCount = 0;
+    int mLodLevel = 0;
+    sprite_t* mImpostor = nullptr;
     
     std::function<void(CSceneObject&, CPlayer&)> mInteractionCallback;
+
+    static CLinearArena* sLodArena;
 };
 
 class CNpcObject : public CSceneObject
 {
 public:
     CNpcObject() = default;
-    virtual ~CNpcObject() = default;
+    virtual ~CNpcObject();
 
     virtual void init(const SSceneObjectDef& def) override;
     virtual void update(float dt) override;
     virtual void draw() override;
+    virtual void destroy() override;
 
     void setDialogueLines(const std::vector<SDialogueLine>& lines) {
         mDialogueLines = lines;
@@ -181,18 +282,42 @@ public:
         return mDialogueLines;
     }
 private:
-    void updateHeadLookAt(float dt);
+    void updateHeadLookAt();
 
     std::vector<SDialogueLine> mDialogueLines{};
-    int mHeadBoneIdx = -1;
-    float mHeadYaw = 0.0f;
-    float mHeadPitch = 0.0f;
+    TSecondaryChain mHeadChain = SECONDARY_CHAIN_INVALID;
+};
+
+class CCrowdObject : public CSceneObject
+{
+public:
+    explicit CCrowdObject(CCrowdPoseCache& cache) : mCache(cache) {}
+    virtual ~CCrowdObject();
+
+    virtual void init(const SSceneObjectDef& def) override;
+    virtual void update(float dt) override;
+    virtual void draw() override;
+    virtual void destroy() override;
+
+    virtual void setFrameIndex(uint32_t frameIndex) override { mFrameIndex = frameIndex; }
+    virtual void updateBufferedMatrix(uint32_t frameIndex) override;
+    virtual void getBounds(TVec3F& outCenter, float& outRadius) const override;
+
+private:
+    CCrowdPoseCache& mCache;
+    SCrowdHandle mHandle{};
+    T3DMat4FP* mBufferedMatrices = nullptr;
+    uint32_t mNumBuffers = 0;
+    uint32_t mFrameIndex = 0;
+    uint32_t mBufferDirtyMask = ~0u;
+    bool mMatricesInArena = false;
 };
 
 struct SSceneDef
 {
     const char* name;
     const char* mapModelPath;
+    const char* mapChunksPath;
     const char* collisionPath;
     TVec3F playerSpawnPos;
     float playerSpawnRotY;
@@ -212,6 +337,9 @@ public:
     ~CScene();
 
     void init(const SSceneDef& def, CPlayer& player, CViewport& viewport, CLight& light, CCamera& camera);
+    void beginLoad(const SSceneDef& def);
+    bool loadStep(uint32_t budgetUs);
+    void activate(CPlayer& player, CCamera& camera);
     void update(float dt, CPlayer& player);
     void draw();
     void exit();
@@ -220,25 +348,71 @@ public:
     void updateBufferedMatrix(uint32_t frameIndex);
 
     CSceneObject* getObject(const char* name);
+    CSceneObject* getObject(uint32_t nameHash);
+    SSceneObjectHandle findObject(uint32_t nameHash) const;
+    CSceneObject* resolve(SSceneObjectHandle handle) const;
     CSceneObject* getObjectAt(int index);
     int getObjectCount() const { return mObjectCount; }
 
     CModel* getMapModel() { return &mMapModel; }
     CCollisionMesh* getCollision() { return &mCollision; }
+    const CCollisionHeightGrid* getHeightGrid() const { return &mHeightGrid; }
 
     const char* getName() const { return mDef ? mDef->name : nullptr; }
     bool isLoaded() const { return mLoaded; }
 
     CSceneObject* checkPlayerInteractions(const TVec3F& playerPos);
 
+    SCrowdStats const& getCrowdStats() const { return mCrowdCache.getStats(); }
+    SSceneCullStats const& getCullStats() const { return mCullStats; }
+    SMapChunkStats const& getMapChunkStats() const { return mMapChunks.getStats(); }
+    SStaticBatchStats const& getStaticBatchStats() const { return mStaticBatch.getStats(); }
+    SSceneLoadStats const& getLoadStats() const { return mLoadStats; }
+    CLinearArena const& getArena() const { return mArena; }
+    CLinearArena const& getMatrixArena() const { return mMatrixArena; }
+
 private:
+    enum class ESceneLoadStep {
+        Idle,
+        Map,
+        Collision,
+        HeightGrid,
+        Objects,
+        Done
+    };
+
+    static void drawMap(void* scene);
+    static void drawStaticBatch(void* scene);
+    CSceneObject* createObject(ESceneObjectType type);
+    void buildObjectRegistry();
+    int findObjectIndex(uint32_t nameHash) const;
+    void buildStaticBatch();
+    void unbatchMovedObjects();
+
     const SSceneDef* mDef = nullptr;
     
     CModel mMapModel{};
+    CMapChunkGrid mMapChunks{};
     CCollisionMesh mCollision{};
+    CCollisionHeightGrid mHeightGrid{};
+    CCrowdPoseCache mCrowdCache{};
+    CStaticBatch mStaticBatch{};
     
     CSceneObject* mObjects[SCENE_MAX_OBJECTS];
     int mObjectCount = 0;
+    uint32_t mRegistryHashes[SCENE_MAX_OBJECTS]{};
+    uint8_t mRegistryIndices[SCENE_MAX_OBJECTS]{};
+    int mRegistryCount = 0;
+    uint32_t mGeneration = 0;
+    static uint32_t sGenerationCounter;
+    SSceneCullStats mCullStats{};
+
+    CLinearArena mArena{};
+    CLinearArena mMatrixArena{};
+
+    ESceneLoadStep mLoadStep = ESceneLoadStep::Idle;
+    int mLoadObjectIndex = 0;
+    SSceneLoadStats mLoadStats{};
     
     bool mLoaded = false;
 };
@@ -298,16 +472,23 @@ public:
     
     ECutsceneAction getCurrentAction() const { return mCurrentAction; }
     const void* getCurrentActionData() const { return mCurrentActionData; }
+
+    SSceneCullStats const& getCullStats() const { return mCullStats; }
     
 private:
     void updateCamera(float dt);
     void checkActions();
+    bool isModelVisible(int index) const;
+    void releaseModels();
     
     const SCutsceneDef* mDef = nullptr;
     CModel* mStaticModels = nullptr;
     CSkinnedModel* mSkinnedModels = nullptr;
     bool* mIsAnimated = nullptr;
+    bool* mVisible = nullptr;
     int mModelCount = 0;
+    CLinearArena mArena{};
+    CLinearArena mMatrixArena{};
     CViewport* mViewport = nullptr;
     
     float mTime = 0.0f;
@@ -322,6 +503,8 @@ private:
     
     ECutsceneAction mCurrentAction = ECutsceneAction::None;
     const void* mCurrentActionData = nullptr;
+
+    SSceneCullStats mCullStats{};
 };
 
 class CSceneManager
@@ -354,6 +537,8 @@ public:
     CScene* getCurrentScene() { return mCurrentScene; }
     CPlayer* getPlayer() { return mPlayer; }
     CCamera* getCamera() { return mCamera; }
+    CViewport* getViewport() { return mViewport; }
+    SSceneCullStats const& getCullStats() const;
     CTextBox* getTextBox() { return &mTextBox; }
     CShop* getShop() { return &mShop; }
     
@@ -370,6 +555,8 @@ public:
 private:
     CSceneManager() = default;
 
+    void activateNextScene();
+
     enum class ESceneTransitionState {
         None = 0,
         StarWipeOut,
@@ -411,13 +598,23 @@ private:
 };
 
 #define SCENE_OBJECT(objName, mdlPath, animName, px, py, pz, rx, ry, rz, sx, sy, sz, radius, interact) \
-    { ESceneObjectType::Base, objName, mdlPath, animName, {px, py, pz}, {rx, ry, rz}, {sx, sy, sz}, radius, interact }
+    { ESceneObjectType::Base, objName, HashUtil::fnv1a(objName), mdlPath, animName, {px, py, pz}, {rx, ry, rz}, {sx, sy, sz}, radius, interact, nullptr }
 
 #define SCENE_OBJECT_NPC(objName, mdlPath, animName, px, py, pz, rx, ry, rz, sx, sy, sz, radius, interact) \
-    { ESceneObjectType::Npc, objName, mdlPath, animName, {px, py, pz}, {rx, ry, rz}, {sx, sy, sz}, radius, interact }
+    { ESceneObjectType::Npc, objName, HashUtil::fnv1a(objName), mdlPath, animName, {px, py, pz}, {rx, ry, rz}, {sx, sy, sz}, radius, interact, nullptr }
+
+// opt-in: background villagers that share skeleton poses through CCrowdPoseCache
+#define SCENE_OBJECT_CROWD(objName, mdlPath, animName, px, py, pz, rx, ry, rz, sx, sy, sz, radius, interact) \
+    { ESceneObjectType::Crowd, objName, HashUtil::fnv1a(objName), mdlPath, animName, {px, py, pz}, {rx, ry, rz}, {sx, sy, sz}, radius, interact, nullptr }
 
 #define SCENE_OBJECT_SIMPLE(objName, mdlPath, px, py, pz) \
-    { ESceneObjectType::Base, objName, mdlPath, nullptr, {px, py, pz}, {0, 0, 0}, {1, 1, 1}, 0.0f, false }
+    { ESceneObjectType::Base, objName, HashUtil::fnv1a(objName), mdlPath, nullptr, {px, py, pz}, {0, 0, 0}, {1, 1, 1}, 0.0f, false, nullptr }
 
 #define SCENE_OBJECT_INTERACTABLE(objName, mdlPath, px, py, pz, radius) \
-    { ESceneObjectType::Base, objName, mdlPath, nullptr, {px, py, pz}, {0, 0, 0}, {1, 1, 1}, radius, true }
+    { ESceneObjectType::Base, objName, HashUtil::fnv1a(objName), mdlPath, nullptr, {px, py, pz}, {0, 0, 0}, {1, 1, 1}, radius, true, nullptr }
+
+#define SCENE_OBJECT_LOD(objName, mdlPath, animName, px, py, pz, rx, ry, rz, sx, sy, sz, radius, interact, lodDef) \
+    { ESceneObjectType::Base, objName, HashUtil::fnv1a(objName), mdlPath, animName, {px, py, pz}, {rx, ry, rz}, {sx, sy, sz}, radius, interact, lodDef }
+
+#define SCENE_OBJECT_NPC_LOD(objName, mdlPath, animName, px, py, pz, rx, ry, rz, sx, sy, sz, radius, interact, lodDef) \
+    { ESceneObjectType::Npc, objName, HashUtil::fnv1a(objName), mdlPath, animName, {px, py, pz}, {rx, ry, rz}, {sx, sy, sz}, radius, interact, lodDef }
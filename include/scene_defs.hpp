@@ -113,6 +113,12 @@ static const SSceneObjectDef sVillageObjects[] = {
         50.0f,                    // collision radius
         true),                   // has interaction
     
+    SCENE_OBJECT_CROWD("villager1", "rom:/npc-tiger.t3dm", "idle",
+        60.0f, -10.8f, 210.0f,     // position
+        0.0f, 180.0f, 0.0f,       // rotation
+        0.125f, 0.125f, 0.125f, // scale
+        0.0f,                     // collision radius
+        false),                  // has interaction
 
     */
 
@@ -139,6 +145,7 @@ static const SSceneObjectDef sCabinObjects[] = {
 static const SSceneDef sVillageSceneDef = {
     .name = "village",
     .mapModelPath = "rom:/village.t3dm",
+    .mapChunksPath = "rom:/village_chunks.t3dm",
     .collisionPath = "rom:/village.bcol",
     .playerSpawnPos = {-50.4f, 0.0f, -230.1f},
     .playerSpawnRotY = 0.0f,
@@ -152,6 +159,7 @@ static const SSceneDef sVillageSceneDef = {
 static const SSceneDef sVillageCabinExitSceneDef = {
     .name = "village",
     .mapModelPath = "rom:/village.t3dm",
+    .mapChunksPath = "rom:/village_chunks.t3dm",
     .collisionPath = "rom:/village.bcol",
     .playerSpawnPos = {589.3f, 14.2f, 133.0f},
     .playerSpawnRotY = 80.0f,
@@ -175,14 +183,23 @@ static const SSceneDef sTestSceneDef = {
     .objectCount = sizeof(sCabinObjects) / sizeof(sCabinObjects[0]),
 };
 
+constexpr uint32_t OBJ_TELEPORT_CABIN = HashUtil::fnv1a("teleport-cabin");
+constexpr uint32_t OBJ_TELEPORT_VILLAGE = HashUtil::fnv1a("teleport-village");
+constexpr uint32_t OBJ_SHOPKEEP = HashUtil::fnv1a("shopkeep");
+
+static SSceneObjectHandle sVillageTeleportCabin{};
+static SSceneObjectHandle sCabinShopkeep{};
+static SSceneObjectHandle sCabinTeleportVillage{};
+
 inline void villageOnInit(CScene& scene)
 {
+    sVillageTeleportCabin = scene.findObject(OBJ_TELEPORT_CABIN);
     debugf("Village scene initialized!\n");
 }
 
 inline void villageOnUpdate(CScene& scene, float dt)
 {
-    CSceneObject* teleportCabin = scene.getObject("teleport-cabin");
+    CSceneObject* teleportCabin = scene.resolve(sVillageTeleportCabin);
     if (teleportCabin && teleportCabin->hasInteraction()) {
         CPlayer* player = CSceneManager::instance().getPlayer();
         if (player) {
@@ -213,7 +230,10 @@ inline void shopCabinOnInit(CScene& scene)
         shop->addShopItems(sShopItems);
     }
     
-    CSceneObject* obj = scene.getObject("shopkeep");
+    sCabinShopkeep = scene.findObject(OBJ_SHOPKEEP);
+    sCabinTeleportVillage = scene.findObject(OBJ_TELEPORT_VILLAGE);
+
+    CSceneObject* obj = scene.resolve(sCabinShopkeep);
     if (obj) {
         CNpcObject* npc = dynamic_cast<CNpcObject*>(obj);
         if (npc) {
@@ -260,7 +280,7 @@ inline void shopCabinOnUpdate(CScene& scene, float dt)
     CMenu* menu = player ? player->getMenu() : nullptr;
     
     if (!dialogueUpdated && menu && menu->getPlayerStats().hasStoryFlag(EStoryFlag::MetShopkeeper)) {
-        CSceneObject* obj = scene.getObject("shopkeep");
+        CSceneObject* obj = scene.resolve(sCabinShopkeep);
         if (obj) {
             CNpcObject* npc = dynamic_cast<CNpcObject*>(obj);
             if (npc) {
@@ -277,7 +297,7 @@ inline void shopCabinOnUpdate(CScene& scene, float dt)
         }
     }
     
-    CSceneObject* teleportCabin = scene.getObject("teleport-village");
+    CSceneObject* teleportCabin = scene.resolve(sCabinTeleportVillage);
     if (teleportCabin && teleportCabin->hasInteraction()) {
         if (player) {
             TVec3F playerPos = player->getPosition();
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <libdragon.h>
+#include <t3d/t3d.h>
+#include <t3d/t3dmath.h>
+#include <t3d/t3dskeleton.h>
+
+constexpr int SECONDARY_MOTION_MAX_CHAINS = 72;
+constexpr int SECONDARY_MOTION_MAX_NODES = 80;
+constexpr float SECONDARY_MOTION_STEP = 1.0f / 60.0f;
+constexpr int SECONDARY_MOTION_MAX_STEPS = 4;
+
+using TSecondaryChain = int;
+constexpr TSecondaryChain SECONDARY_CHAIN_INVALID = -1;
+
+enum class ESecondaryApplyMode : uint8_t
+{
+    Additive,
+    FromRest
+};
+
+struct SSecondaryChainDef
+{
+    float stiffness{45.0f};
+    float damping{3.0f};
+    float follow{1.0f};
+    float maxVelocity{8.0f};
+    float limits[3]{0.8f, 0.8f, 0.8f};
+    ESecondaryApplyMode mode{ESecondaryApplyMode::Additive};
+};
+
+class CSecondaryMotion
+{
+public:
+    static CSecondaryMotion& instance();
+
+    TSecondaryChain addChain(T3DSkeleton* skeleton, const int* bones, int boneCount, SSecondaryChainDef const& def);
+    void removeChain(TSecondaryChain chain);
+    void clear();
+
+    void setTarget(TSecondaryChain chain, float a0, float a1, float a2);
+    float getAngle(TSecondaryChain chain, int node, int axis) const;
+
+    void update(float dt);
+    void apply(TSecondaryChain chain);
+
+    int getChainCount() const { return mChainCount; }
+    int getNodeCount() const { return mNodeCount; }
+
+private:
+    CSecondaryMotion() = default;
+
+    struct SChain
+    {
+        T3DSkeleton* skeleton{nullptr};
+        SSecondaryChainDef def{};
+        float target[3]{};
+        uint16_t firstNode{0};
+        uint16_t nodeCount{0};
+        bool active{false};
+    };
+
+    bool isValidChain(TSecondaryChain chain) const { return chain >= 0 && chain < SECONDARY_MOTION_MAX_CHAINS && mChains[chain].active; }
+    void step(float h);
+
+    SChain mChains[SECONDARY_MOTION_MAX_CHAINS]{};
+    int mChainCount{0};
+
+    float mAngle[3][SECONDARY_MOTION_MAX_NODES]{};
+    float mVelocity[3][SECONDARY_MOTION_MAX_NODES]{};
+    T3DQuat mRest[SECONDARY_MOTION_MAX_NODES]{};
+    int16_t mBone[SECONDARY_MOTION_MAX_NODES]{};
+    uint8_t mNodeChain[SECONDARY_MOTION_MAX_NODES]{};
+    int mNodeCount{0};
+
+    float mAccumulator{0.0f};
+};
@@ -1,15 +1,84 @@
 #pragma once
 
 #include <string>
-#include <unordered_map>
 #include <libdragon.h>
 #include <t3d/t3d.h>
 #include <t3d/t3dmodel.h>
 #include <t3d/t3dskeleton.h>
 #include <t3d/t3danim.h>
 #include "model.hpp"
+#include "anim_events.hpp"
+#include "anim_clip_library.hpp"
+
+class CViewport;
 
 constexpr int SKINNED_MODEL_SEGMENT_ID = 1;
+constexpr int SKINNED_MODEL_MAX_ANIMATIONS = 16;
+
+using TAnimHandle = int;
+constexpr TAnimHandle ANIM_HANDLE_INVALID = -1;
+
+constexpr int SKINNED_MODEL_MAX_SOCKETS = 4;
+
+using TSocketHandle = int;
+constexpr TSocketHandle SOCKET_HANDLE_INVALID = -1;
+
+constexpr int ANIM_MAX_LAYERS = 4;
+constexpr uint16_t ANIM_BONE_NO_PARENT = 0xFFFF;
+
+constexpr int ANIM_LOD_LEVELS = 3;
+constexpr float ANIM_LOD_BOUNDS_PADDING = 1.25f;
+constexpr float ANIM_LOD_MAX_STEP = 0.25f;
+
+constexpr float ANIM_BAKE_DEFAULT_RATE = 30.0f;
+constexpr uint32_t ANIM_BAKE_DEFAULT_CLIP_BUDGET = 64 * 1024;
+constexpr uint32_t ANIM_BAKE_DEFAULT_TOTAL_BUDGET = 128 * 1024;
+
+// model-space bone pose, quantised: rotation in 1/32767, position in clip units, scale in 1/4096
+struct SBakedBone
+{
+    int16_t rotation[4];
+    int16_t position[3];
+    int16_t scale[3];
+};
+
+struct SBakedClip
+{
+    SBakedBone* frames{nullptr};
+    T3DMat4FP* pose{nullptr};
+    uint32_t bytes{0};
+    uint16_t frameCount{0};
+    uint16_t boneCount{0};
+    float rate{0.0f};
+    float duration{0.0f};
+    float positionUnit{1.0f};
+};
+
+struct SAnimLodStats
+{
+    uint32_t full{0};
+    uint32_t reduced{0};
+    uint32_t culled{0};
+    uint32_t skeletonUpdates{0};
+};
+
+struct SAnimLayer
+{
+    T3DVec3* position{nullptr};
+    T3DQuat* rotation{nullptr};
+    T3DVec3* scale{nullptr};
+    int32_t* changed{nullptr};
+    uint8_t* mask{nullptr};
+    float weight{0.0f};
+    bool masked{false};
+};
+
+struct SBoneSocket
+{
+    T3DMat4 offset{};
+    T3DMat4 world{};
+    int bone{-1};
+};
 
 class CSkinnedModel : public CModel
 {
@@ -23,44 +92,108 @@ public:
     
     void setFrameIndex(uint32_t frameIndex) { mFrameIndex = frameIndex; }
 
-    void createSkeleton();
-    void addAnimation(std::string const& name, int skeletonType = 0);
-    void playAnimation(std::string const& name);
-    void stopAnimation(std::string const& name);
-    void setAnimationSpeed(std::string const& name, float speed);
-    void setAnimationLooping(std::string const& name, bool loop);
-    void resetAnimation(std::string const& name);
-    bool isAnimationFinished(std::string const& name) const;
-    bool isAnimationPlaying(std::string const& name) const;
-    void updateAnimation(std::string const& name, float dt);
+    void createSkeleton(int layerCount = 1);
+    TAnimHandle addAnimation(std::string const& name, int layer = 0);
+    TAnimHandle findAnimation(std::string const& name) const;
+    void playAnimation(TAnimHandle handle);
+    void stopAnimation(TAnimHandle handle);
+    void setAnimationSpeed(TAnimHandle handle, float speed);
+    void setAnimationLooping(TAnimHandle handle, bool loop);
+    void resetAnimation(TAnimHandle handle);
+    bool isAnimationFinished(TAnimHandle handle) const;
+    bool isAnimationPlaying(TAnimHandle handle) const;
+    void updateAnimation(TAnimHandle handle, float dt);
     void updateAnimations(float dt);
-    void blendAnimations(std::string const& animA, std::string const& animB, float blendFactor);
+    void setLayerWeight(int layer, float weight);
+    void setLayerMask(int layer, const char* rootBone);
+    void clearLayerMask(int layer);
+    void blendLayers();
+    int getLayerCount() const { return mLayerCount; }
     void updateSkeleton();
     
-    float getAnimationFrame(std::string const& name) const;
+    void bindAnimationEvents(CAnimEventTrackSet const& tracks);
+    bool popAnimationEvent(SAnimEventRecord& outRecord) { return mAnimEventQueue.pop(outRecord); }
+
+    float getAnimationFrame(TAnimHandle handle) const;
+    int getAnimationCount() const { return mAnimationCount; }
+
+    void setAnimLodDistances(float nearDist, float farDist) { mAnimLodNear = nearDist; mAnimLodFar = farDist; }
+    bool stepAnimationLod(float dt, const CViewport* viewport, float& outDt);
+    int getAnimLodLevel() const { return mAnimLodLevel; }
+    bool isAnimCulled() const { return mAnimCulled; }
+
+    static SAnimLodStats const& getAnimLodStats() { return sAnimLodStats; }
+    static void resetAnimLodStats() { sAnimLodStats = {}; }
+
+    bool bakeAnimation(TAnimHandle handle, float rate = ANIM_BAKE_DEFAULT_RATE);
+    void setBakedPlayback(bool enabled);
+    bool hasBakedAnimation() const { return mBakedHandle != ANIM_HANDLE_INVALID; }
+    bool isBakedPlaybackActive() const { return mBakedPlayback; }
+
+    static void setAnimBakeBudget(uint32_t clipBytes, uint32_t totalBytes) { sAnimBakeClipBudget = clipBytes; sAnimBakeTotalBudget = totalBytes; }
+    static uint32_t getAnimBakeBytesUsed() { return sAnimBakeBytesUsed; }
 
     T3DSkeleton* getSkeleton() { return &mSkeleton; }
-    T3DSkeleton* getBlendSkeleton() { return &mSkeletonBlend; }
-    T3DSkeleton* getActionSkeleton() { return &mSkeletonAction; }
+    int findBones(const char* const* names, int count, int* outBones);
+
+    TSocketHandle addSocket(const char* boneName, const T3DMat4* offset = nullptr);
+    void updateSockets(const T3DMat4* modelMatrix = nullptr);
+    const T3DMat4* getSocketMatrix(TSocketHandle handle) const;
+    T3DVec3 getSocketPosition(TSocketHandle handle) const;
+    bool isValidSocket(TSocketHandle handle) const { return handle >= 0 && handle < mSocketCount; }
 
     void buildSkinnedDisplayList();
     
-    void blendAction(float weight);
-    
     void updateBufferedMatrix(uint32_t frameIndex);
     
     void setBufferedMatrixFromMat4(const T3DMat4* mat);
 
 private:
+    bool isValidAnimation(TAnimHandle handle) const { return handle >= 0 && handle < mAnimationCount; }
+    bool isValidLayer(int layer) const { return layer > 0 && layer < mLayerCount; }
+    void freeBakedAnimation();
+    void updateBakedPose();
+    void destroyAnimation(T3DAnim& anim);
+    void fireAnimationEvents(TAnimHandle handle, float prevTime, float time);
+
+    std::string mPath{};
+    TAnimRig mRig{ANIM_RIG_INVALID};
     T3DSkeleton mSkeleton{};
-    T3DSkeleton mSkeletonBlend{};
-    T3DSkeleton mSkeletonAction{};
-    std::unordered_map<std::string, T3DAnim> mAnimations{};
+    SAnimLayer mLayers[ANIM_MAX_LAYERS]{};
+    void* mLayerPool{nullptr};
+    int mLayerCount{0};
+    T3DAnim mAnimations[SKINNED_MODEL_MAX_ANIMATIONS]{};
+    std::string mAnimationNames[SKINNED_MODEL_MAX_ANIMATIONS]{};
+    int mAnimationLayers[SKINNED_MODEL_MAX_ANIMATIONS]{};
+    const SAnimEvent* mAnimEventTracks[SKINNED_MODEL_MAX_ANIMATIONS]{};
+    uint16_t mAnimEventCounts[SKINNED_MODEL_MAX_ANIMATIONS]{};
+    CAnimEventQueue mAnimEventQueue{};
+    int mAnimationCount{0};
     bool mHasSkeleton{false};
-    bool mHasBlendSkeleton{false};
-    bool mHasActionSkeleton{false};
     
     T3DMat4FP* mBufferedMatrices{nullptr};
     uint32_t mNumBuffers{0};
     uint32_t mFrameIndex{0};
+    bool mBufferedInArena{false};
+
+    float mAnimLodNear{150.0f};
+    float mAnimLodFar{300.0f};
+    float mAnimLodAccum{0.0f};
+    uint32_t mAnimLodCounter{0};
+    int mAnimLodLevel{0};
+    bool mAnimCulled{false};
+
+    SBoneSocket mSockets[SKINNED_MODEL_MAX_SOCKETS]{};
+    int mSocketCount{0};
+
+    SBakedClip mBakedClip{};
+    TAnimHandle mBakedHandle{ANIM_HANDLE_INVALID};
+    float mBakedTime{0.0f};
+    uint32_t mBakedPoseFrame{UINT32_MAX};
+    bool mBakedPlayback{false};
+
+    static SAnimLodStats sAnimLodStats;
+    static uint32_t sAnimBakeClipBudget;
+    static uint32_t sAnimBakeTotalBudget;
+    static uint32_t sAnimBakeBytesUsed;
 };
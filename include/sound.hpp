@@ -7,7 +7,7 @@
 
 struct TSoundRes
 {
-    wav64_t waveRes;
+    wav64_t* waveRes;
     int32_t id;
     int32_t loopStart;
     int32_t loopEnd;
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <libdragon.h>
+#include <t3d/t3d.h>
+#include <t3d/t3dmodel.h>
+#include "math.hpp"
+#include "model.hpp"
+
+class CViewport;
+
+constexpr int STATIC_BATCH_MAX_GROUPS = 8;
+constexpr int STATIC_BATCH_MAX_INSTANCES = 32;
+
+struct SStaticBatchStats
+{
+    uint32_t groups{0};
+    uint32_t instances{0};
+    uint32_t drawn{0};
+    uint32_t culled{0};
+};
+
+class CStaticBatch
+{
+public:
+    CStaticBatch() = default;
+    ~CStaticBatch();
+
+    bool add(CModel* model, const char* key);
+    bool remove(CModel* model);
+    void build();
+    void clear();
+    void draw(const CViewport* viewport);
+
+    bool isEmpty() const { return mGroupCount == 0; }
+    SStaticBatchStats const& getStats() const { return mStats; }
+
+private:
+    struct SGroup
+    {
+        const char* key{nullptr};
+        CModel* instances[STATIC_BATCH_MAX_INSTANCES]{};
+        int count{0};
+        T3DMat4FP* matrices{nullptr};
+        rspq_block_t* displayList{nullptr};
+        TVec3F boundsCenter{0.0f, 0.0f, 0.0f};
+        float boundsRadius{0.0f};
+    };
+
+    SGroup* findGroup(const char* key);
+    void buildGroup(SGroup& group);
+    void freeGroup(SGroup& group);
+
+    SGroup mGroups[STATIC_BATCH_MAX_GROUPS]{};
+    int mGroupCount{0};
+    SStaticBatchStats mStats{};
+};
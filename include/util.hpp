@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <libdragon.h>
 #include <t3d/t3dmath.h>
 
@@ -29,6 +30,28 @@ namespace MathUtil {
     }
 }
 
+namespace HashUtil {
+
+    constexpr uint32_t FNV_OFFSET = 2166136261u;
+    constexpr uint32_t FNV_PRIME = 16777619u;
+
+    constexpr uint32_t fnv1a(const char* str, uint32_t hash = FNV_OFFSET) {
+        if (str == nullptr) return 0;
+        while (*str) {
+            hash = (hash ^ static_cast<uint8_t>(*str++)) * FNV_PRIME;
+        }
+        return hash;
+    }
+
+    inline uint32_t fnv1a(const void* data, uint32_t size, uint32_t hash = FNV_OFFSET) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (uint32_t i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * FNV_PRIME;
+        }
+        return hash;
+    }
+}
+
 class TUtil
 {
     public:
@@ -15,10 +15,18 @@ public:
     void lookAt(TVec3F const& camPos, TVec3F const& target);
     void attach();
 
+    bool isSphereVisible(TVec3F const& center, float radius) const;
+    bool isAabbVisible(TVec3F const& min, TVec3F const& max) const;
+
     T3DViewport* getViewport() { return &mViewport; }
+    TVec3F const& getCameraPosition() const { return mCameraPosition; }
 
 private:
+    void updateFrustum();
+
     T3DViewport mViewport{};
+    T3DFrustum mFrustum{};
+    TVec3F mCameraPosition{0.0f, 0.0f, 0.0f};
     float mFov{85.0f};
     float mNear{10.0f};
     float mFar{150.0f};
@@ -0,0 +1,185 @@
+#include "anim_clip_library.hpp"
+#include "util.hpp"
+#include "asset_cache.hpp"
+#include <cstring>
+
+CAnimClipLibrary& CAnimClipLibrary::instance()
+{
+    static CAnimClipLibrary sInstance;
+    return sInstance;
+}
+
+uint32_t CAnimClipLibrary::computeRigHash(const T3DModel* model)
+{
+    const T3DChunkSkeleton* skeleton = model ? t3d_model_get_skeleton(model) : nullptr;
+    if (!skeleton) return 0;
+
+    uint32_t hash = HashUtil::fnv1a(&skeleton->boneCount, sizeof(skeleton->boneCount));
+    for (uint32_t b = 0; b < skeleton->boneCount; ++b) {
+        const T3DChunkBone& bone = skeleton->bones[b];
+        hash = HashUtil::fnv1a(bone.name, hash);
+        hash = HashUtil::fnv1a(&bone.parentIdx, sizeof(bone.parentIdx), hash);
+    }
+    return hash;
+}
+
+TAnimRig CAnimClipLibrary::acquireRig(const T3DModel* model, const char* path)
+{
+    uint32_t hash = computeRigHash(model);
+    if (hash == 0 || !path) return ANIM_RIG_INVALID;
+
+    TAnimRig rig = findRig(hash);
+    if (rig != ANIM_RIG_INVALID) {
+        ++mStats.hits;
+    } else {
+        rig = findFreeRig();
+        if (rig == ANIM_RIG_INVALID) {
+            debugf("CAnimClipLibrary: no free rig slot for %s\n", path);
+            return ANIM_RIG_INVALID;
+        }
+        mRigs[rig].hash = hash;
+        ++mStats.rigs;
+        ++mStats.misses;
+    }
+
+    SRig& entry = mRigs[rig];
+    SSource* source = findSource(entry, model);
+    if (!source) {
+        if (entry.sourceCount >= ANIM_CLIP_LIBRARY_MAX_SOURCES) {
+            debugf("CAnimClipLibrary: rig for %s has no free source slot, clips stay local\n", path);
+            return rig;
+        }
+        source = &entry.sources[entry.sourceCount++];
+        source->model = model;
+        strncpy(source->path, path, ANIM_CLIP_PATH_LENGTH - 1);
+        source->path[ANIM_CLIP_PATH_LENGTH - 1] = '\0';
+        ++mStats.sources;
+    }
+
+    ++source->owners;
+    updateSource(entry, *source);
+    return rig;
+}
+
+void CAnimClipLibrary::releaseRig(TAnimRig rig, const T3DModel* model)
+{
+    if (!isValidRig(rig)) return;
+
+    SRig& entry = mRigs[rig];
+    SSource* source = findSource(entry, model);
+    if (!source || source->owners <= 0) return;
+
+    --source->owners;
+    updateSource(entry, *source);
+}
+
+T3DAnim CAnimClipLibrary::createCursor(TAnimRig rig, const char* name, const T3DModel* fallback)
+{
+    const T3DModel* model = fallback;
+    SSource* source = nullptr;
+    if (isValidRig(rig)) {
+        SRig& entry = mRigs[rig];
+        source = findSource(entry, fallback);
+        if (!source || t3d_model_get_animation(source->model, name) == nullptr) {
+            source = nullptr;
+            for (int i = 0; i < entry.sourceCount; ++i) {
+                if (t3d_model_get_animation(entry.sources[i].model, name) != nullptr) {
+                    source = &entry.sources[i];
+                    break;
+                }
+            }
+        }
+
+        if (source) {
+            model = source->model;
+        } else {
+            debugf("CAnimClipLibrary: clip %s not in any rig source, using fallback model\n", name);
+        }
+    }
+
+    T3DAnim anim = t3d_anim_create(model, name);
+    if (anim.animRef) {
+        ++mStats.cursors;
+        if (source) {
+            ++source->cursors;
+        }
+    }
+    return anim;
+}
+
+void CAnimClipLibrary::destroyCursor(TAnimRig rig, T3DAnim& anim)
+{
+    SSource* source = nullptr;
+    if (anim.animRef && isValidRig(rig)) {
+        SRig& entry = mRigs[rig];
+        for (int i = 0; i < entry.sourceCount; ++i) {
+            if (entry.sources[i].cursors > 0 &&
+                t3d_model_get_animation(entry.sources[i].model, anim.animRef->name) == anim.animRef) {
+                source = &entry.sources[i];
+                break;
+            }
+        }
+    }
+
+    if (anim.animRef && mStats.cursors > 0) {
+        --mStats.cursors;
+    }
+    t3d_anim_destroy(&anim);
+
+    if (source) {
+        --source->cursors;
+        updateSource(mRigs[rig], *source);
+    }
+}
+
+TAnimRig CAnimClipLibrary::findRig(uint32_t hash) const
+{
+    for (int i = 0; i < ANIM_CLIP_LIBRARY_MAX_RIGS; ++i) {
+        if (mRigs[i].sourceCount > 0 && mRigs[i].hash == hash) {
+            return i;
+        }
+    }
+    return ANIM_RIG_INVALID;
+}
+
+TAnimRig CAnimClipLibrary::findFreeRig() const
+{
+    for (int i = 0; i < ANIM_CLIP_LIBRARY_MAX_RIGS; ++i) {
+        if (mRigs[i].sourceCount == 0) return i;
+    }
+    return ANIM_RIG_INVALID;
+}
+
+CAnimClipLibrary::SSource* CAnimClipLibrary::findSource(SRig& rig, const T3DModel* model)
+{
+    for (int i = 0; i < rig.sourceCount; ++i) {
+        if (rig.sources[i].model == model) {
+            return &rig.sources[i];
+        }
+    }
+    return nullptr;
+}
+
+void CAnimClipLibrary::updateSource(SRig& rig, SSource& source)
+{
+    // owners keep their own model resident; the library only pins it for cursors that outlive them
+    bool pinned = source.owners == 0 && source.cursors > 0;
+    if (pinned && !source.retained) {
+        CAssetCache::instance().acquireModel(source.path);
+        source.retained = true;
+    } else if (!pinned && source.retained) {
+        CAssetCache::instance().releaseData(source.model);
+        source.retained = false;
+    }
+
+    if (source.owners > 0 || source.cursors > 0) return;
+
+    source = rig.sources[--rig.sourceCount];
+    rig.sources[rig.sourceCount] = {};
+    --mStats.sources;
+
+    if (rig.sourceCount == 0) {
+        rig = {};
+        --mStats.rigs;
+    }
+}
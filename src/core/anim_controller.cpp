@@ -5,76 +5,105 @@ void CAnimController::init(CSkinnedModel* model)
     mModel = model;
 }
 
-void CAnimController::setBaseAnimation(const std::string& name, const AnimationConfig& config)
+void CAnimController::setBaseAnimation(TAnimHandle anim, const AnimationConfig& config)
 {
-    mBaseAnim = name;
-    mModel->setAnimationLooping(name, config.loops);
-    mModel->setAnimationSpeed(name, config.speed);
+    mBaseAnim = anim;
+    mModel->setAnimationLooping(anim, config.loops);
+    mModel->setAnimationSpeed(anim, config.speed);
 }
 
-void CAnimController::setMovementAnimation(const std::string& name, const AnimationConfig& config)
+void CAnimController::setMovementAnimation(TAnimHandle anim, const AnimationConfig& config)
 {
-    mMovementAnim = name;
-    mModel->setAnimationLooping(name, config.loops);
-    mModel->setAnimationSpeed(name, config.speed);
+    mMovementAnim = anim;
+    mModel->setAnimationLooping(anim, config.loops);
+    mModel->setAnimationSpeed(anim, config.speed);
 }
 
-void CAnimController::registerAction(const std::string& name, const AnimationConfig& config)
+void CAnimController::registerAction(TAnimHandle anim, const AnimationConfig& config)
 {
-    mModel->setAnimationLooping(name, config.loops);
-    mModel->setAnimationSpeed(name, config.speed);
-    mModel->stopAnimation(name);
+    mModel->setAnimationLooping(anim, config.loops);
+    mModel->setAnimationSpeed(anim, config.speed);
+    mModel->stopAnimation(anim);
 }
 
 void CAnimController::setMovementSpeed(float speed)
 {
-    if (!mMovementAnim.empty()) {
+    if (mMovementAnim != ANIM_HANDLE_INVALID) {
         mModel->setAnimationSpeed(mMovementAnim, speed);
     }
 }
 
-void CAnimController::playAction(const std::string& name)
+void CAnimController::playAction(TAnimHandle anim)
 {
-    mActionAnim = name;
+    mActionAnim = anim;
     mActionActive = true;
     mActionHold = false;
     mActionWeight = 0.0f;
     
-    mModel->resetAnimation(name);
-    mModel->playAnimation(name);
+    mModel->resetAnimation(anim);
+    mModel->playAnimation(anim);
 }
 
-void CAnimController::playActionSeamless(const std::string& name)
+void CAnimController::playActionSeamless(TAnimHandle anim)
 {
     float preservedWeight = mActionWeight;
     
-    mActionAnim = name;
+    mActionAnim = anim;
     mActionActive = true;
     mActionHold = false;
     mActionWeight = preservedWeight > 0.5f ? preservedWeight : 1.0f;
     
-    mModel->resetAnimation(name);
-    mModel->playAnimation(name);
+    mModel->resetAnimation(anim);
+    mModel->playAnimation(anim);
 }
 
 void CAnimController::stopAction()
 {
-    if (mActionAnim.empty()) return;
+    if (mActionAnim == ANIM_HANDLE_INVALID) return;
     
     mModel->stopAnimation(mActionAnim);
     mActionActive = false;
     mActionHold = false;
 }
 
+// the mask only changes while the action layer has no weight, otherwise the masked-out bones would pop
+void CAnimController::setActionMask(const char* rootBone)
+{
+    mPendingMaskBone = rootBone;
+    mMaskPending = true;
+    if (mActionWeight <= 0.0f) applyPendingMask();
+}
+
+void CAnimController::clearActionMask()
+{
+    mPendingMaskBone = nullptr;
+    mMaskPending = true;
+    if (mActionWeight <= 0.0f) applyPendingMask();
+}
+
+void CAnimController::applyPendingMask()
+{
+    if (mPendingMaskBone) {
+        mModel->setLayerMask(ANIM_CONTROLLER_ACTION_LAYER, mPendingMaskBone);
+    } else {
+        mModel->clearLayerMask(ANIM_CONTROLLER_ACTION_LAYER);
+    }
+    mMaskPending = false;
+}
+
 bool CAnimController::isActionFinished() const
 {
-    if (!mModel || mActionAnim.empty()) return true;
+    if (!mModel || mActionAnim == ANIM_HANDLE_INVALID) return true;
     return !mModel->isAnimationPlaying(mActionAnim);
 }
 
 void CAnimController::update(float dt)
 {
     if (!mModel) return;
+
+    if (mMaskPending && mActionWeight <= 0.0f) {
+        applyPendingMask();
+    }
     
     const float blendSpeed = 8.0f;
     if (mCurrentBlend < mTargetBlend) {
@@ -100,19 +129,19 @@ void CAnimController::update(float dt)
         mActionWeight -= actionBlendOutSpeed * dt;
         if (mActionWeight < 0.1f) {
             mActionWeight = 0.0f;
-            mActionAnim.clear();
+            mActionAnim = ANIM_HANDLE_INVALID;
         }
     }
     
-    if (!mBaseAnim.empty()) {
+    if (mBaseAnim != ANIM_HANDLE_INVALID) {
         mModel->updateAnimation(mBaseAnim, dt);
     }
     
-    if (!mMovementAnim.empty()) {
+    if (mMovementAnim != ANIM_HANDLE_INVALID && (mCurrentBlend > 0.0f || mTargetBlend > 0.0f)) {
         mModel->updateAnimation(mMovementAnim, dt);
     }
     
-    if (!mActionAnim.empty() && (mActionActive || mActionWeight > 0.0f)) {
+    if (mActionAnim != ANIM_HANDLE_INVALID && (mActionActive || mActionWeight > 0.0f)) {
         mModel->updateAnimation(mActionAnim, dt);
     }
     
@@ -120,9 +149,7 @@ void CAnimController::update(float dt)
     if (mActionWeight > 0.0f) {
         effectiveBlend *= (1.0f - mActionWeight * 0.7f);
     }
-    mModel->blendAnimations(mBaseAnim, mMovementAnim, effectiveBlend);
-    
-    if (mActionWeight > 0.0f) {
-        mModel->blendAction(mActionWeight);
-    }
+    mModel->setLayerWeight(ANIM_CONTROLLER_MOVEMENT_LAYER, effectiveBlend);
+    mModel->setLayerWeight(ANIM_CONTROLLER_ACTION_LAYER, mActionWeight);
+    mModel->blendLayers();
 }
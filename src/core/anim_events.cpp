@@ -0,0 +1,96 @@
+#include "anim_events.hpp"
+#include <cstring>
+
+CAnimEventTrackSet::~CAnimEventTrackSet()
+{
+    unload();
+}
+
+bool CAnimEventTrackSet::load(const char* path)
+{
+    unload();
+
+    FILE* file = asset_fopen(path, nullptr);
+    if (!file) {
+        debugf("Failed to open animation events: %s\n", path);
+        return false;
+    }
+
+    SAevtHeader header{};
+    if (fread(&header, sizeof(SAevtHeader), 1, file) != 1 || memcmp(header.magic, "AEVT", 4) != 0) {
+        debugf("Invalid animation event file: %s\n", path);
+        fclose(file);
+        return false;
+    }
+
+    mClips = new SAevtClip[header.clipCount];
+    if (fread(mClips, sizeof(SAevtClip), header.clipCount, file) != header.clipCount) {
+        debugf("Truncated animation event file: %s\n", path);
+        fclose(file);
+        unload();
+        return false;
+    }
+    mClipCount = header.clipCount;
+
+    uint16_t eventCount = 0;
+    for (int i = 0; i < mClipCount; ++i) {
+        uint16_t end = mClips[i].firstEvent + mClips[i].eventCount;
+        if (end > eventCount) eventCount = end;
+    }
+
+    mEvents = new SAnimEvent[eventCount];
+    if (fread(mEvents, sizeof(SAnimEvent), eventCount, file) != eventCount) {
+        debugf("Truncated animation event file: %s\n", path);
+        fclose(file);
+        unload();
+        return false;
+    }
+    mEventCount = eventCount;
+
+    fclose(file);
+    return true;
+}
+
+void CAnimEventTrackSet::unload()
+{
+    delete[] mClips;
+    delete[] mEvents;
+    mClips = nullptr;
+    mEvents = nullptr;
+    mClipCount = 0;
+    mEventCount = 0;
+}
+
+const SAnimEvent* CAnimEventTrackSet::findTrack(const char* clipName, uint16_t& outCount) const
+{
+    outCount = 0;
+    for (int i = 0; i < mClipCount; ++i) {
+        if (strncmp(mClips[i].name, clipName, ANIM_EVENT_NAME_LENGTH) == 0) {
+            outCount = mClips[i].eventCount;
+            return outCount > 0 ? &mEvents[mClips[i].firstEvent] : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+bool CAnimEventQueue::push(SAnimEventRecord const& record)
+{
+    if (mCount >= ANIM_EVENT_QUEUE_SIZE) {
+        debugf("CAnimEventQueue: queue full, dropping event\n");
+        return false;
+    }
+
+    mRecords[(mHead + mCount) % ANIM_EVENT_QUEUE_SIZE] = record;
+    ++mCount;
+    return true;
+}
+
+bool CAnimEventQueue::pop(SAnimEventRecord& outRecord)
+{
+    if (mCount == 0) return false;
+
+    outRecord = mRecords[mHead];
+    mHead = (mHead + 1) % ANIM_EVENT_QUEUE_SIZE;
+    --mCount;
+    return true;
+}
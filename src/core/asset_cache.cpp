@@ -0,0 +1,205 @@
+#include "asset_cache.hpp"
+#include "util.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static uint32_t fileSize(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) return 0;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size > 0 ? static_cast<uint32_t>(size) : 0;
+}
+
+CAssetCache& CAssetCache::instance()
+{
+    static CAssetCache sInstance;
+    return sInstance;
+}
+
+uint32_t CAssetCache::hashPath(const char* path)
+{
+    return HashUtil::fnv1a(path);
+}
+
+TAssetHandle CAssetCache::acquire(EAssetType type, const char* path)
+{
+    if (!path) return ASSET_HANDLE_INVALID;
+
+    uint32_t hash = hashPath(path);
+    TAssetHandle handle = find(type, hash, path);
+    if (handle != ASSET_HANDLE_INVALID) {
+        ++mEntries[handle].refCount;
+        mEntries[handle].lastUse = ++mUseCounter;
+        ++mStats.hits;
+        return handle;
+    }
+
+    handle = findFree();
+    if (handle == ASSET_HANDLE_INVALID) {
+        debugf("CAssetCache: no free entry for %s\n", path);
+        return ASSET_HANDLE_INVALID;
+    }
+
+    SEntry& entry = mEntries[handle];
+    if (!loadEntry(entry, type, path)) {
+        debugf("CAssetCache: failed to load %s\n", path);
+        return ASSET_HANDLE_INVALID;
+    }
+
+    strncpy(entry.path, path, ASSET_CACHE_PATH_LENGTH - 1);
+    entry.path[ASSET_CACHE_PATH_LENGTH - 1] = '\0';
+    entry.hash = hash;
+    entry.type = type;
+    entry.refCount = 1;
+    entry.lastUse = ++mUseCounter;
+
+    ++mStats.misses;
+    ++mStats.entries;
+    mStats.bytesResident += entry.bytes;
+
+    evictToBudget();
+    return handle;
+}
+
+void CAssetCache::release(TAssetHandle handle)
+{
+    if (!isValid(handle) || mEntries[handle].refCount <= 0) return;
+
+    --mEntries[handle].refCount;
+    mEntries[handle].lastUse = ++mUseCounter;
+    evictToBudget();
+}
+
+void CAssetCache::releaseData(const void* data)
+{
+    if (!data) return;
+
+    for (int i = 0; i < ASSET_CACHE_MAX_ENTRIES; ++i) {
+        if (mEntries[i].data == data) {
+            release(i);
+            return;
+        }
+    }
+}
+
+T3DModel* CAssetCache::getModel(TAssetHandle handle) const
+{
+    return isValid(handle) && mEntries[handle].type == EAssetType::Model ? static_cast<T3DModel*>(mEntries[handle].data) : nullptr;
+}
+
+sprite_t* CAssetCache::getSprite(TAssetHandle handle) const
+{
+    return isValid(handle) && mEntries[handle].type == EAssetType::Sprite ? static_cast<sprite_t*>(mEntries[handle].data) : nullptr;
+}
+
+wav64_t* CAssetCache::getSound(TAssetHandle handle) const
+{
+    return isValid(handle) && mEntries[handle].type == EAssetType::Sound ? static_cast<wav64_t*>(mEntries[handle].data) : nullptr;
+}
+
+void CAssetCache::setBudget(uint32_t bytes)
+{
+    mBudget = bytes;
+    evictToBudget();
+}
+
+void CAssetCache::trim()
+{
+    for (int i = 0; i < ASSET_CACHE_MAX_ENTRIES; ++i) {
+        if (mEntries[i].data && mEntries[i].refCount == 0) {
+            freeEntry(mEntries[i]);
+            ++mStats.evictions;
+        }
+    }
+}
+
+TAssetHandle CAssetCache::find(EAssetType type, uint32_t hash, const char* path) const
+{
+    for (int i = 0; i < ASSET_CACHE_MAX_ENTRIES; ++i) {
+        const SEntry& entry = mEntries[i];
+        if (entry.data && entry.hash == hash && entry.type == type && strcmp(entry.path, path) == 0) {
+            return i;
+        }
+    }
+    return ASSET_HANDLE_INVALID;
+}
+
+TAssetHandle CAssetCache::findFree()
+{
+    TAssetHandle oldest = ASSET_HANDLE_INVALID;
+    for (int i = 0; i < ASSET_CACHE_MAX_ENTRIES; ++i) {
+        if (!mEntries[i].data) return i;
+        if (mEntries[i].refCount == 0 && (oldest == ASSET_HANDLE_INVALID || mEntries[i].lastUse < mEntries[oldest].lastUse)) {
+            oldest = i;
+        }
+    }
+
+    if (oldest != ASSET_HANDLE_INVALID) {
+        freeEntry(mEntries[oldest]);
+        ++mStats.evictions;
+    }
+    return oldest;
+}
+
+bool CAssetCache::loadEntry(SEntry& entry, EAssetType type, const char* path)
+{
+    switch (type) {
+        case EAssetType::Model:
+            entry.data = t3d_model_load(path);
+            entry.bytes = fileSize(path);
+            break;
+        case EAssetType::Sprite:
+            entry.data = sprite_load(path);
+            entry.bytes = fileSize(path);
+            break;
+        case EAssetType::Sound: {
+            wav64_t* wave = static_cast<wav64_t*>(malloc(sizeof(wav64_t)));
+            wav64_open(wave, path);
+            entry.data = wave;
+            entry.bytes = sizeof(wav64_t);
+            break;
+        }
+    }
+    return entry.data != nullptr;
+}
+
+void CAssetCache::freeEntry(SEntry& entry)
+{
+    switch (entry.type) {
+        case EAssetType::Model:
+            t3d_model_free(static_cast<T3DModel*>(entry.data));
+            break;
+        case EAssetType::Sprite:
+            sprite_free(static_cast<sprite_t*>(entry.data));
+            break;
+        case EAssetType::Sound:
+            wav64_close(static_cast<wav64_t*>(entry.data));
+            free(entry.data);
+            break;
+    }
+
+    --mStats.entries;
+    mStats.bytesResident -= entry.bytes;
+    entry = {};
+}
+
+void CAssetCache::evictToBudget()
+{
+    while (mStats.bytesResident > mBudget) {
+        TAssetHandle oldest = ASSET_HANDLE_INVALID;
+        for (int i = 0; i < ASSET_CACHE_MAX_ENTRIES; ++i) {
+            if (mEntries[i].data && mEntries[i].refCount == 0 && (oldest == ASSET_HANDLE_INVALID || mEntries[i].lastUse < mEntries[oldest].lastUse)) {
+                oldest = i;
+            }
+        }
+        if (oldest == ASSET_HANDLE_INVALID) return;
+
+        freeEntry(mEntries[oldest]);
+        ++mStats.evictions;
+    }
+}
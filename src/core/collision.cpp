@@ -549,3 +549,91 @@ bool CCollisionMesh::raycast(float ox, float oy, float oz,
     
     return false;
 }
+
+static constexpr float COL_HEIGHT_GRID_EMPTY = -1.0e6f;
+
+CCollisionHeightGrid::~CCollisionHeightGrid() {
+    clear();
+}
+
+void CCollisionHeightGrid::build(const CCollisionMesh& mesh, float cellSize) {
+    clear();
+    
+    if (!mesh.isLoaded()) return;
+    
+    float minX, minY, minZ, maxX, maxY, maxZ;
+    mesh.getAABB(minX, minY, minZ, maxX, maxY, maxZ);
+    
+    mCellSize = cellSize;
+    mInvCellSize = 1.0f / cellSize;
+    mOriginX = minX;
+    mOriginZ = minZ;
+    mWidth = (int)ceilf((maxX - minX) * mInvCellSize) + 1;
+    mHeight = (int)ceilf((maxZ - minZ) * mInvCellSize) + 1;
+    
+    mHeights = new float[mWidth * mHeight];
+    
+    float startY = maxY + 1.0f;
+    float maxDrop = (maxY - minY) + 2.0f;
+    int found = 0;
+    
+    for (int gz = 0; gz < mHeight; gz++) {
+        for (int gx = 0; gx < mWidth; gx++) {
+            float x = mOriginX + gx * mCellSize;
+            float z = mOriginZ + gz * mCellSize;
+            ColFloorResult floor = mesh.findFloor(x, startY, z, maxDrop);
+            if (floor.found) {
+                mHeights[gz * mWidth + gx] = floor.floorY;
+                found++;
+            } else {
+                mHeights[gz * mWidth + gx] = COL_HEIGHT_GRID_EMPTY;
+            }
+        }
+    }
+    
+    debugf("Height grid: %dx%d cells (%.0f units), %d with floor\n", mWidth, mHeight, mCellSize, found);
+}
+
+void CCollisionHeightGrid::clear() {
+    if (mHeights) {
+        delete[] mHeights;
+        mHeights = nullptr;
+    }
+    mWidth = 0;
+    mHeight = 0;
+}
+
+bool CCollisionHeightGrid::sampleHeight(float x, float z, float* outHeight) const {
+    if (!mHeights) return false;
+    
+    float fx = (x - mOriginX) * mInvCellSize;
+    float fz = (z - mOriginZ) * mInvCellSize;
+    if (fx < 0.0f || fz < 0.0f) return false;
+    
+    int gx = (int)fx;
+    int gz = (int)fz;
+    if (gx >= mWidth - 1 || gz >= mHeight - 1) return false;
+    
+    const float* row0 = &mHeights[gz * mWidth + gx];
+    const float* row1 = row0 + mWidth;
+    float h00 = row0[0], h10 = row0[1];
+    float h01 = row1[0], h11 = row1[1];
+    
+    if (h00 == COL_HEIGHT_GRID_EMPTY || h10 == COL_HEIGHT_GRID_EMPTY ||
+        h01 == COL_HEIGHT_GRID_EMPTY || h11 == COL_HEIGHT_GRID_EMPTY) {
+        float h = h00;
+        if (h10 > h) h = h10;
+        if (h01 > h) h = h01;
+        if (h11 > h) h = h11;
+        if (h == COL_HEIGHT_GRID_EMPTY) return false;
+        *outHeight = h;
+        return true;
+    }
+    
+    float tx = fx - gx;
+    float tz = fz - gz;
+    float h0 = h00 + (h10 - h00) * tx;
+    float h1 = h01 + (h11 - h01) * tx;
+    *outHeight = h0 + (h1 - h0) * tz;
+    return true;
+}
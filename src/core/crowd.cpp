@@ -0,0 +1,218 @@
+#include "crowd.hpp"
+#include "skinned_model.hpp"
+#include "asset_cache.hpp"
+#include <cstring>
+#include <cmath>
+
+CCrowdPoseCache::~CCrowdPoseCache()
+{
+    clear();
+}
+
+SCrowdHandle CCrowdPoseCache::acquire(const char* modelPath, const char* animName)
+{
+    SCrowdHandle handle{};
+    if (modelPath == nullptr || animName == nullptr) return handle;
+
+    int index = findEntry(modelPath, animName);
+    if (index < 0) {
+        for (int i = 0; i < CROWD_MAX_ENTRIES; ++i) {
+            if (mEntries[i].model == nullptr) {
+                index = i;
+                break;
+            }
+        }
+        if (index < 0) {
+            debugf("CCrowdPoseCache: no free entry for %s\n", modelPath);
+            return handle;
+        }
+        if (!createEntry(mEntries[index], modelPath, animName)) {
+            return handle;
+        }
+        ++mStats.entries;
+    }
+
+    SEntry& entry = mEntries[index];
+    int slot = entry.nextSlot;
+    entry.nextSlot = (entry.nextSlot + 1) % CROWD_PHASE_SLOTS;
+
+    if (!entry.poses[slot].created) {
+        createPose(entry, slot);
+    }
+
+    ++entry.refCount;
+    ++mStats.instances;
+
+    handle.entry = index;
+    handle.slot = slot;
+    return handle;
+}
+
+void CCrowdPoseCache::release(SCrowdHandle handle)
+{
+    if (!handle.isValid()) return;
+
+    SEntry& entry = mEntries[handle.entry];
+    if (entry.refCount <= 0) return;
+
+    --mStats.instances;
+    if (--entry.refCount == 0) {
+        destroyEntry(entry);
+    }
+}
+
+void CCrowdPoseCache::clear()
+{
+    for (int i = 0; i < CROWD_MAX_ENTRIES; ++i) {
+        destroyEntry(mEntries[i]);
+    }
+    mStats = {};
+}
+
+void CCrowdPoseCache::requestPose(SCrowdHandle handle)
+{
+    if (!handle.isValid()) return;
+    mEntries[handle.entry].poses[handle.slot].requested = true;
+}
+
+void CCrowdPoseCache::update(float dt)
+{
+    for (int i = 0; i < CROWD_MAX_ENTRIES; ++i) {
+        SEntry& entry = mEntries[i];
+        if (entry.model == nullptr) continue;
+
+        for (int s = 0; s < CROWD_PHASE_SLOTS; ++s) {
+            SPose& pose = entry.poses[s];
+            if (!pose.created) continue;
+
+            // looping clips only need the phase, so unrequested time wraps instead of piling up
+            pose.pendingDt += dt;
+            if (pose.anim.animRef && pose.anim.animRef->duration > 0.0f) {
+                pose.pendingDt = fmodf(pose.pendingDt, pose.anim.animRef->duration);
+            }
+            if (!pose.requested) continue;
+
+            t3d_anim_update(&pose.anim, pose.pendingDt);
+            t3d_skeleton_update(&pose.skeleton);
+            pose.pendingDt = 0.0f;
+            pose.requested = false;
+            ++mStats.poseUpdates;
+        }
+    }
+}
+
+void CCrowdPoseCache::draw(SCrowdHandle handle, const T3DMat4FP* matrix)
+{
+    if (!handle.isValid()) return;
+
+    SEntry& entry = mEntries[handle.entry];
+    if (entry.displayList == nullptr) return;
+
+    t3d_segment_set(SKINNED_MODEL_SEGMENT_ID, (void*)matrix);
+    t3d_skeleton_use(&entry.poses[handle.slot].skeleton);
+    rspq_block_run(entry.displayList);
+}
+
+float CCrowdPoseCache::getBoundsRadius(SCrowdHandle handle) const
+{
+    if (!handle.isValid()) return 0.0f;
+    return mEntries[handle.entry].boundsRadius;
+}
+
+int CCrowdPoseCache::findEntry(const char* modelPath, const char* animName) const
+{
+    for (int i = 0; i < CROWD_MAX_ENTRIES; ++i) {
+        const SEntry& entry = mEntries[i];
+        if (entry.model == nullptr) continue;
+        if (strcmp(entry.modelPath, modelPath) == 0 && strcmp(entry.animName, animName) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool CCrowdPoseCache::createEntry(SEntry& entry, const char* modelPath, const char* animName)
+{
+    entry.model = CAssetCache::instance().acquireModel(modelPath);
+    if (entry.model == nullptr) {
+        debugf("CCrowdPoseCache: failed to load %s\n", modelPath);
+        return false;
+    }
+
+    entry.rig = CAnimClipLibrary::instance().acquireRig(entry.model, modelPath);
+    entry.modelPath = modelPath;
+    entry.animName = animName;
+    entry.nextSlot = 0;
+    entry.refCount = 0;
+
+    float hx = (entry.model->aabbMax[0] - entry.model->aabbMin[0]) * 0.5f;
+    float hy = (entry.model->aabbMax[1] - entry.model->aabbMin[1]) * 0.5f;
+    float hz = (entry.model->aabbMax[2] - entry.model->aabbMin[2]) * 0.5f;
+    float cx = entry.model->aabbMin[0] + hx;
+    float cy = entry.model->aabbMin[1] + hy;
+    float cz = entry.model->aabbMin[2] + hz;
+    entry.boundsRadius = sqrtf(cx * cx + cy * cy + cz * cz) + sqrtf(hx * hx + hy * hy + hz * hz);
+
+    createPose(entry, 0);
+
+    rspq_block_begin();
+    t3d_matrix_push((const T3DMat4FP*)t3d_segment_placeholder(SKINNED_MODEL_SEGMENT_ID));
+    rdpq_set_prim_color(RGBA32(255, 255, 255, 255));
+    t3d_model_draw_skinned(entry.model, &entry.poses[0].skeleton);
+    t3d_matrix_pop(1);
+    entry.displayList = rspq_block_end();
+
+    return true;
+}
+
+void CCrowdPoseCache::createPose(SEntry& entry, int slot)
+{
+    SPose& pose = entry.poses[slot];
+
+    pose.skeleton = t3d_skeleton_create_buffered(entry.model, display_get_num_buffers());
+    pose.anim = CAnimClipLibrary::instance().createCursor(entry.rig, entry.animName, entry.model);
+    t3d_anim_attach(&pose.anim, &pose.skeleton);
+    t3d_anim_set_looping(&pose.anim, true);
+    t3d_anim_set_playing(&pose.anim, true);
+
+    if (pose.anim.animRef != nullptr) {
+        float phase = pose.anim.animRef->duration * slot / CROWD_PHASE_SLOTS;
+        t3d_anim_set_time(&pose.anim, phase);
+    }
+
+    t3d_skeleton_update(&pose.skeleton);
+
+    pose.pendingDt = 0.0f;
+    pose.requested = false;
+    pose.created = true;
+    ++mStats.poses;
+}
+
+void CCrowdPoseCache::destroyEntry(SEntry& entry)
+{
+    if (entry.model == nullptr) return;
+
+    for (int s = 0; s < CROWD_PHASE_SLOTS; ++s) {
+        SPose& pose = entry.poses[s];
+        if (!pose.created) continue;
+
+        CAnimClipLibrary::instance().destroyCursor(entry.rig, pose.anim);
+        t3d_skeleton_destroy(&pose.skeleton);
+        pose.created = false;
+        --mStats.poses;
+    }
+
+    if (entry.displayList) {
+        rspq_block_free(entry.displayList);
+        entry.displayList = nullptr;
+    }
+
+    CAnimClipLibrary::instance().releaseRig(entry.rig, entry.model);
+    entry.rig = ANIM_RIG_INVALID;
+    CAssetCache::instance().releaseData(entry.model);
+    entry.model = nullptr;
+    entry.modelPath = nullptr;
+    entry.animName = nullptr;
+    entry.refCount = 0;
+    --mStats.entries;
+}
@@ -0,0 +1,57 @@
+#include "linear_arena.hpp"
+#include <cstdlib>
+#include <malloc.h>
+
+CLinearArena::~CLinearArena()
+{
+    destroy();
+}
+
+bool CLinearArena::init(uint32_t capacity, bool uncached)
+{
+    destroy();
+
+    mBase = static_cast<uint8_t*>(uncached ? malloc_uncached(capacity) : memalign(16, capacity));
+    if (!mBase) {
+        debugf("CLinearArena: failed to allocate %lu bytes\n", capacity);
+        return false;
+    }
+
+    mCapacity = capacity;
+    mUncached = uncached;
+    mUsed = 0;
+    mPeak = 0;
+    return true;
+}
+
+void CLinearArena::destroy()
+{
+    if (mBase) {
+        if (mUncached) {
+            free_uncached(mBase);
+        } else {
+            free(mBase);
+        }
+    }
+    mBase = nullptr;
+    mCapacity = 0;
+    mUsed = 0;
+    mPeak = 0;
+}
+
+void CLinearArena::reset()
+{
+    mUsed = 0;
+}
+
+void* CLinearArena::alloc(uint32_t size, uint32_t align)
+{
+    if (!mBase) return nullptr;
+
+    uint32_t offset = (mUsed + align - 1) & ~(align - 1);
+    if (offset + size > mCapacity) return nullptr;
+
+    mUsed = offset + size;
+    if (mUsed > mPeak) mPeak = mUsed;
+    return mBase + offset;
+}
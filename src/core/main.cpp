@@ -17,7 +17,11 @@
 #include "skinned_model.hpp"
 #include "light.hpp"
 #include "player.hpp"
+#include "secondary_motion.hpp"
 #include "particle.hpp"
+#include "particle_effect.hpp"
+#include "render_queue.hpp"
+#include "asset_cache.hpp"
 #include "wipe.hpp"
 #include "collision.hpp"
 #include "textbox.hpp"
@@ -30,6 +34,34 @@ float get_time_s() {
   return (float)((double)get_ticks_us() / 1000000.0);
 }
 
+void drawDebugOverlay(float x, float y, CPlayer& player)
+{
+	TVec3F const& playerPos = player.getPosition();
+	SParticleStats const& ptx = CParticleSystem::instance().getStats();
+	SAnimLodStats const& anim = CSkinnedModel::getAnimLodStats();
+	SRenderQueueStats const& rq = CRenderQueue::instance().getStats();
+	SAssetCacheStats const& asset = CAssetCache::instance().getStats();
+
+	rdpq_text_printf(NULL, FONT_BUILTIN_DEBUG_MONO, x, y, "FPS: %.1f", display_get_fps());
+	rdpq_text_printf(NULL, FONT_BUILTIN_DEBUG_MONO, x, y + 8, "%.1f, %.1f, %.1f", playerPos.x(), playerPos.y(), playerPos.z());
+	rdpq_text_printf(NULL, FONT_BUILTIN_DEBUG_MONO, x, y + 16, "%.1f", player.getSpeed());
+	rdpq_text_printf(NULL, FONT_BUILTIN_DEBUG_MONO, x, y + 24, "PTX cull:%lu sim:%lu draw:%lu", ptx.culled, ptx.simulated, ptx.drawn);
+	rdpq_text_printf(NULL, FONT_BUILTIN_DEBUG_MONO, x, y + 32, "ANIM full:%lu red:%lu cull:%lu skel:%lu",
+	                 anim.full, anim.reduced, anim.culled, anim.skeletonUpdates);
+	if (CSceneManager::instance().getCurrentScene()) {
+		SCrowdStats const& crowd = CSceneManager::instance().getCurrentScene()->getCrowdStats();
+		rdpq_text_printf(NULL, FONT_BUILTIN_DEBUG_MONO, x, y + 40, "CROWD inst:%lu pose:%lu upd:%lu cull:%lu",
+		                 crowd.instances, crowd.poses, crowd.poseUpdates, crowd.culled);
+	}
+	rdpq_text_printf(NULL, FONT_BUILTIN_DEBUG_MONO, x, y + 48, "OBJ draw:%lu cull:%lu",
+	                 CSceneManager::instance().getCullStats().drawn, CSceneManager::instance().getCullStats().culled);
+	rdpq_text_printf(NULL, FONT_BUILTIN_DEBUG_MONO, x, y + 56, "RQ %s pkt:%lu state:%lu sync:%lu",
+	                 CRenderQueue::instance().isSorted() ? "sorted" : "unsorted", rq.packets, rq.stateChanges, rq.syncs);
+	rdpq_text_printf(NULL, FONT_BUILTIN_DEBUG_MONO, x, y + 64, "MTX rebuild:%lu", CModel::getMatrixRebuilds());
+	rdpq_text_printf(NULL, FONT_BUILTIN_DEBUG_MONO, x, y + 72, "ASSET hit:%lu miss:%lu res:%luK",
+	                 asset.hits, asset.misses, asset.bytesResident / 1024);
+}
+
 void modelTestInit()
 {
 	CViewport viewport{};
@@ -61,24 +93,25 @@ void modelTestInit()
 	CSceneManager::instance().startLogoScene(&sExampleCutsceneDef);
 	//CSceneManager::instance().loadScene(sVillageSceneDef);
 
-	CContinuousEmitter snowEmitter{};
-	snowEmitter.init(600);
-	snowEmitter.setGravity({0.0f, -15.0f, 0.0f});
-	snowEmitter.setFadeOverLife(false);
-	snowEmitter.setEmissionRate(600.0f);
-	snowEmitter.setSpawnVelocity({-5.0f, -10.0f, -5.0f}, {5.0f, -3.0f, 5.0f});
-	snowEmitter.setSpawnSize(1.0f, 3.0f);
-	snowEmitter.setSpawnLife(3.0f, 5.0f);
-	snowEmitter.setSpawnColor(255, 255, 255, 220);
-	snowEmitter.setSpawnSpread(175.0f);
-	snowEmitter.setWorldScale(1.0f);
-	snowEmitter.setPosition({0.0f, 80.0f, 0.0f});
-	snowEmitter.start();
-
-	CParticleEmitter burstEmitter{};
-	burstEmitter.init(50);
-	burstEmitter.setGravity({0.0f, -15.0f, 0.0f});
-	burstEmitter.setFadeOverLife(true);
+	CParticleSystem& particles = CParticleSystem::instance();
+	particles.init();
+	particles.setViewport(&viewport);
+
+	CParticleEffect snowEffect{};
+	snowEffect.load("rom:/snow.pfx");
+
+	CSnowEmitter* snowEmitter = particles.createEmitter<CSnowEmitter>(snowEffect.getMaxParticles(), 1, snowEffect.getRenderState());
+	snowEffect.configure(*snowEmitter);
+	snowEmitter->setSettleTime(0.6f);
+	snowEmitter->setSimulationSlices(3);
+	snowEmitter->setPosition({0.0f, 80.0f, 0.0f});
+	snowEmitter->start();
+
+	CParticleEffect burstEffect{};
+	burstEffect.load("rom:/burst.pfx");
+
+	CParticleEmitter* burstEmitter = particles.createEmitter<CParticleEmitter>(burstEffect.getMaxParticles(), 0, burstEffect.getRenderState());
+	burstEffect.configure(*burstEmitter);
 
 	CMenu pauseMenu{};
 	pauseMenu.init(FONT_BUILTIN_DEBUG_MONO);
@@ -121,7 +154,6 @@ void modelTestInit()
 	float dayNightTime = 0.0f;
 
 	float lastTime = get_time_s() - (1.0f / 60.0f);
-	rspq_syncpoint_t syncPoint = 0;
 	
 	uint32_t frameIndex = 0;
 
@@ -131,6 +163,7 @@ void modelTestInit()
 	float villageMusicTimer = 0.0f;
 	float villageMusicDelay = 60.0f;
 	bool hasPlayedVillageMusic = false;
+	bool debugOverlay = false;
 
 	dayNightTime = 40.0f;
 	for(;;)
@@ -174,7 +207,12 @@ void modelTestInit()
 		uint8_t fogG = (uint8_t)(dayFogG + (nightFogG - dayFogG) * dayNightBlend);
 		uint8_t fogB = (uint8_t)(dayFogB + (nightFogB - dayFogB) * dayNightBlend);
 
+		CModel::resetMatrixRebuilds();
+		CModel::setFrameIndex(frameIndex);
 		CSceneManager::instance().setFrameIndex(frameIndex);
+		particles.setFrameIndex(frameIndex);
+		
+		CSecondaryMotion::instance().update(deltaTime);
 		
 		if (!CSceneManager::instance().isInCutscene() && !CSceneManager::instance().isInLogoScene()) {
 			player.setFrameIndex(frameIndex);
@@ -190,16 +228,28 @@ void modelTestInit()
 		}
 	}
 	
-	CSceneManager::instance().updateBufferedMatrix(frameIndex);
-
-		
-		TVec3F focusPos = CSceneManager::instance().getFocusPosition();
-		snowEmitter.setPosition({focusPos.x(), focusPos.y() + 40.0f, focusPos.z()});
-		snowEmitter.update(deltaTime);
-
 		joypad_buttons_t btn = joypad_get_buttons_pressed(JOYPAD_PORT_1);
 		joypad_buttons_t held = joypad_get_buttons_held(JOYPAD_PORT_1);
 		joypad_inputs_t joypad = joypad_get_inputs(JOYPAD_PORT_1);
+
+		// camera first, so animation LOD, visibility and particle culling all test this frame's frustum
+		TVec3F playerPos = player.getPosition();
+		if (!CSceneManager::instance().isInCutscene() && !CSceneManager::instance().isInLogoScene()) {
+			camera.update(deltaTime, playerPos, joypad);
+			
+			CScene* currentScene = CSceneManager::instance().getCurrentScene();
+			if (currentScene != nullptr) {
+				CCollisionMesh* collision = currentScene->getCollision();
+				if (collision != nullptr && collision->isLoaded()) {
+					camera.applyCollision(*collision);
+				}
+			}
+
+			player.setCameraAngle(camera.getOrbitAngle());
+
+			viewport.setProjection(85.0f, 10.0f, 1000.0f);
+			camera.apply(viewport);
+		}
 		
 		CShop* shop = CSceneManager::instance().getShop();
 		bool shopActive = shop && shop->isOpen();
@@ -211,6 +261,13 @@ void modelTestInit()
 			pauseMenu.toggle();
 		}
 		
+		if (held.z && btn.d_left) {
+			debugOverlay = !debugOverlay;
+		}
+		if (debugOverlay && held.z && btn.d_right) {
+			CRenderQueue::instance().setSorted(!CRenderQueue::instance().isSorted());
+		}
+		
 		totalPlayTime += deltaTime;
 		pauseMenu.addPlayTime(deltaTime);
 		
@@ -227,8 +284,6 @@ void modelTestInit()
 			
 		}
 		
-		burstEmitter.update(deltaTime);
-
 		CSceneManager::instance().update(deltaTime);
 		std::string currentSceneName{};
 
@@ -236,23 +291,14 @@ void modelTestInit()
 			currentSceneName = CSceneManager::instance().getCurrentScene()->getName();
 		}
 		
-		TVec3F playerPos = player.getPosition();
-		if (!CSceneManager::instance().isInCutscene() && !CSceneManager::instance().isInLogoScene()) {
-			camera.update(deltaTime, playerPos, joypad);
-			
-			CScene* currentScene = CSceneManager::instance().getCurrentScene();
-			if (currentScene != nullptr) {
-				CCollisionMesh* collision = currentScene->getCollision();
-				if (collision != nullptr && collision->isLoaded()) {
-					camera.applyCollision(*collision);
-				}
-			}
-
-			player.setCameraAngle(camera.getOrbitAngle());
-
-			viewport.setProjection(85.0f, 10.0f, 1000.0f);
-			camera.apply(viewport);
-		}
+		CSceneManager::instance().updateBufferedMatrix(frameIndex);
+		
+		TVec3F focusPos = CSceneManager::instance().getFocusPosition();
+		snowEmitter->setPosition({focusPos.x(), focusPos.y() + 40.0f, focusPos.z()});
+		CScene* snowScene = CSceneManager::instance().getCurrentScene();
+		snowEmitter->setHeightGrid(snowScene ? snowScene->getHeightGrid() : nullptr);
+		particles.update(deltaTime);
+		particles.updateBufferedMatrix(frameIndex);
 
 		if (currentSceneName == "village") {
 			mixer_ch_set_vol(0, 0.3f, 0.3f);
@@ -284,8 +330,6 @@ void modelTestInit()
 
 		CSoundMgr::update();
 
-		if(syncPoint) rspq_syncpoint_wait(syncPoint);
-
 		surface_t* disp = display_get();
 		rdpq_attach(disp, display_get_zbuf());
 		
@@ -317,7 +361,7 @@ void modelTestInit()
 		if (CSceneManager::instance().isInCutscene()) {
 			t3d_fog_set_range(0.4f, 550.0f);
 		} else {
-			t3d_fog_set_range(0.4f, 150.0f);
+			t3d_fog_set_range(0.4f, SCENE_FOG_FAR);
 		}
 		
 
@@ -329,6 +373,7 @@ void modelTestInit()
 			t3d_fog_set_enabled(false);
 		}
 
+		CRenderQueue::instance().begin(viewport.getCameraPosition());
 		CSceneManager::instance().draw();
 
 		if (!CSceneManager::instance().isInCutscene() && !CSceneManager::instance().isInLogoScene()) {
@@ -339,9 +384,9 @@ void modelTestInit()
 			}
 		}
 
-		if (currentSceneName == "village" || CSceneManager::instance().isInCutscene()) {
-			snowEmitter.draw();
-		}
+		snowEmitter->setVisible(currentSceneName == "village" || CSceneManager::instance().isInCutscene());
+		particles.draw();
+		CRenderQueue::instance().flush();
 		
 		CSceneManager::instance().drawUI(); 
 
@@ -349,8 +394,6 @@ void modelTestInit()
 		//shatter.draw();
 		//drownWipe.draw();
 
-		
-		syncPoint = rspq_syncpoint_new();
 
 		CSceneManager::instance().drawTransitionOverlays();
 
@@ -359,10 +402,9 @@ void modelTestInit()
 
 		rdpq_sync_pipe();
 		
-		//rdpq_text_printf(NULL, FONT_BUILTIN_DEBUG_MONO, posX, posY, "FPS: %.1f", display_get_fps());
-		//rdpq_text_printf(NULL, FONT_BUILTIN_DEBUG_MONO, posX, posY + 8, "%.1f, %.1f, %.1f", 
-		//                 playerPos.x(), playerPos.y(), playerPos.z());
-		//rdpq_text_printf(NULL, FONT_BUILTIN_DEBUG_MONO, posX, posY + 16, "%.1f", player.getSpeed());
+		if (debugOverlay) {
+			drawDebugOverlay(posX, posY, player);
+		}
 		
 		player.drawItemGetOverlay(FONT_BUILTIN_DEBUG_MONO);
 		player.drawExpGainAnimation(FONT_BUILTIN_DEBUG_MONO);
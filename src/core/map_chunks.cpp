@@ -0,0 +1,140 @@
+#include "map_chunks.hpp"
+#include "viewport.hpp"
+#include "asset_cache.hpp"
+#include <cstring>
+
+static float axisDistance(float v, float lo, float hi)
+{
+    if (v < lo) return lo - v;
+    if (v > hi) return v - hi;
+    return 0.0f;
+}
+
+CMapChunkGrid::~CMapChunkGrid()
+{
+    unload();
+}
+
+bool CMapChunkGrid::load(const char* path)
+{
+    unload();
+
+    mModel = CAssetCache::instance().acquireModel(path);
+    if (!mModel) {
+        debugf("CMapChunkGrid: failed to load %s\n", path);
+        return false;
+    }
+
+    T3DModelIter it = t3d_model_iter_create(mModel, T3D_CHUNK_TYPE_OBJECT);
+    while (t3d_model_iter_next(&it)) {
+        const T3DObject* object = it.object;
+        TVec3F lo{(float)object->aabbMin[0], (float)object->aabbMin[1], (float)object->aabbMin[2]};
+        TVec3F hi{(float)object->aabbMax[0], (float)object->aabbMax[1], (float)object->aabbMax[2]};
+
+        SMapChunk* chunk = findChunk(object->name);
+        if (chunk) {
+            chunk->aabbMin = {TMath<float>::min(chunk->aabbMin.x(), lo.x()), TMath<float>::min(chunk->aabbMin.y(), lo.y()), TMath<float>::min(chunk->aabbMin.z(), lo.z())};
+            chunk->aabbMax = {TMath<float>::max(chunk->aabbMax.x(), hi.x()), TMath<float>::max(chunk->aabbMax.y(), hi.y()), TMath<float>::max(chunk->aabbMax.z(), hi.z())};
+            continue;
+        }
+
+        if (mChunkCount >= MAP_CHUNK_MAX_CHUNKS) {
+            debugf("CMapChunkGrid: too many chunks in %s, dropping %s\n", path, object->name);
+            continue;
+        }
+
+        SMapChunk& added = mChunks[mChunkCount++];
+        added.name = object->name;
+        added.aabbMin = lo;
+        added.aabbMax = hi;
+    }
+
+    mMatrixFP = static_cast<T3DMat4FP*>(malloc_uncached(sizeof(T3DMat4FP)));
+    t3d_mat4fp_identity(mMatrixFP);
+
+    buildDisplayLists();
+    return true;
+}
+
+void CMapChunkGrid::unload()
+{
+    for (int i = 0; i < mChunkCount; ++i) {
+        if (mChunks[i].displayList) {
+            rspq_block_free(mChunks[i].displayList);
+        }
+        mChunks[i] = {};
+    }
+    mChunkCount = 0;
+    mStats = {};
+
+    if (mMatrixFP) {
+        free_uncached(mMatrixFP);
+        mMatrixFP = nullptr;
+    }
+    if (mModel) {
+        CAssetCache::instance().releaseData(mModel);
+        mModel = nullptr;
+    }
+}
+
+void CMapChunkGrid::draw(const CViewport* viewport, float drawDistance)
+{
+    mStats = {};
+    if (!mModel) return;
+
+    TVec3F cam = viewport ? viewport->getCameraPosition() : TVec3F{0.0f, 0.0f, 0.0f};
+    float maxDistSq = drawDistance * drawDistance;
+
+    for (int i = 0; i < mChunkCount; ++i) {
+        const SMapChunk& chunk = mChunks[i];
+
+        if (viewport) {
+            float dx = axisDistance(cam.x(), chunk.aabbMin.x(), chunk.aabbMax.x());
+            float dy = axisDistance(cam.y(), chunk.aabbMin.y(), chunk.aabbMax.y());
+            float dz = axisDistance(cam.z(), chunk.aabbMin.z(), chunk.aabbMax.z());
+            if (dx * dx + dy * dy + dz * dz > maxDistSq) {
+                ++mStats.distanceCulled;
+                continue;
+            }
+            if (!viewport->isAabbVisible(chunk.aabbMin, chunk.aabbMax)) {
+                ++mStats.frustumCulled;
+                continue;
+            }
+        }
+
+        rspq_block_run(chunk.displayList);
+        ++mStats.drawn;
+    }
+}
+
+bool CMapChunkGrid::filterChunk(void* userData, const T3DObject* object)
+{
+    return strcmp(static_cast<const char*>(userData), object->name) == 0;
+}
+
+SMapChunk* CMapChunkGrid::findChunk(const char* name)
+{
+    for (int i = 0; i < mChunkCount; ++i) {
+        if (strcmp(mChunks[i].name, name) == 0) {
+            return &mChunks[i];
+        }
+    }
+    return nullptr;
+}
+
+void CMapChunkGrid::buildDisplayLists()
+{
+    for (int i = 0; i < mChunkCount; ++i) {
+        SMapChunk& chunk = mChunks[i];
+
+        rspq_block_begin();
+        t3d_matrix_push(mMatrixFP);
+        rdpq_set_prim_color(RGBA32(255, 255, 255, 255));
+        t3d_model_draw_custom(mModel, (T3DModelDrawConf){
+            .userData = (void*)chunk.name,
+            .filterCb = filterChunk
+        });
+        t3d_matrix_pop(1);
+        chunk.displayList = rspq_block_end();
+    }
+}
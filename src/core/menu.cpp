@@ -2,6 +2,7 @@
 #include "player.hpp"
 #include "sound.hpp"
 #include "save_manager.hpp"
+#include "asset_cache.hpp"
 #include <cstring>
 #include <cmath>
 #include <cstdio>
@@ -23,8 +24,9 @@ void CMenu::init(int fontId)
     mScrollOffset = 0;
     mAnimProgress = 0.0f;
     
-    mCursorSprite = sprite_load("rom:/sflk.ia16.sprite");
-    mCheckSprite = sprite_load("rom:/check.ci4.sprite");    mButtonSprite = sprite_load("rom:/btns.ci4.sprite");    
+    mCursorSprite = CAssetCache::instance().acquireSprite("rom:/sflk.ia16.sprite");
+    mCheckSprite = CAssetCache::instance().acquireSprite("rom:/check.ci4.sprite");
+    mButtonSprite = CAssetCache::instance().acquireSprite("rom:/btns.ci4.sprite");
     mPlayerStats = {};
     mPlayerStats.level = 1;
     mPlayerStats.expToNextLevel = 100;
@@ -40,7 +42,7 @@ void CMenu::init(int fontId)
 void CMenu::loadIcons(const char* spritePath)
 {
     freeSprite(mIconSprite);
-    mIconSprite = sprite_load(spritePath);
+    mIconSprite = CAssetCache::instance().acquireSprite(spritePath);
 }
 
 void CMenu::toggle()
@@ -142,7 +144,7 @@ void CMenu::setAlphaBlitMode()
 void CMenu::freeSprite(sprite_t*& sprite)
 {
     if (sprite) {
-        sprite_free(sprite);
+        CAssetCache::instance().releaseData(sprite);
         sprite = nullptr;
     }
 }
@@ -1,4 +1,28 @@
 #include "model.hpp"
+#include "asset_cache.hpp"
+#include <cmath>
+
+uint32_t CModel::sMatrixRebuilds = 0;
+CLinearArena* CModel::sMatrixArena = nullptr;
+uint32_t CModel::sFrameIndex = 0;
+
+T3DMat4FP* CModel::allocMatrices(uint32_t count, bool& outInArena)
+{
+    T3DMat4FP* matrices = sMatrixArena ? static_cast<T3DMat4FP*>(sMatrixArena->alloc(sizeof(T3DMat4FP) * count)) : nullptr;
+    outInArena = matrices != nullptr;
+    if (!matrices) {
+        matrices = static_cast<T3DMat4FP*>(malloc_uncached(sizeof(T3DMat4FP) * count));
+    }
+    return matrices;
+}
+
+void CModel::freeMatrices(T3DMat4FP*& matrices, bool inArena)
+{
+    if (matrices && !inArena) {
+        free_uncached(matrices);
+    }
+    matrices = nullptr;
+}
 
 CModel::~CModel()
 {
@@ -11,12 +35,10 @@ void CModel::unload()
         rspq_block_free(mDisplayList);
         mDisplayList = nullptr;
     }
-    if (mMatrixFP) {
-        free_uncached(mMatrixFP);
-        mMatrixFP = nullptr;
-    }
+    freeMatrices(mMatrixFP, mMatrixInArena);
+    mMatrixCount = 0;
     if (mModel) {
-        t3d_model_free(mModel);
+        CAssetCache::instance().releaseData(mModel);
         mModel = nullptr;
     }
 }
@@ -24,14 +46,40 @@ void CModel::unload()
 void CModel::load(std::string const& path)
 {
     unload();
-    mModel = t3d_model_load(path.c_str());
-    mMatrixFP = static_cast<T3DMat4FP*>(malloc_uncached(sizeof(T3DMat4FP)));
+    mModel = CAssetCache::instance().acquireModel(path.c_str());
+    mMatrixCount = display_get_num_buffers();
+    mMatrixFP = allocMatrices(mMatrixCount, mMatrixInArena);
+    markDirty();
     updateMatrix();
+
+    if (mModel) {
+        float hx = (mModel->aabbMax[0] - mModel->aabbMin[0]) * 0.5f;
+        float hy = (mModel->aabbMax[1] - mModel->aabbMin[1]) * 0.5f;
+        float hz = (mModel->aabbMax[2] - mModel->aabbMin[2]) * 0.5f;
+        mBoundsCenter = {
+            mModel->aabbMin[0] + hx,
+            mModel->aabbMin[1] + hy,
+            mModel->aabbMin[2] + hz
+        };
+        mBoundsRadius = sqrtf(hx * hx + hy * hy + hz * hz);
+    }
+}
+
+void CModel::getBoundingSphere(TVec3F& outCenter, float& outRadius) const
+{
+    float maxScale = TMath<float>::max(mScale.x(), TMath<float>::max(mScale.y(), mScale.z()));
+    float cx = mBoundsCenter.x(), cy = mBoundsCenter.y(), cz = mBoundsCenter.z();
+    float offset = sqrtf(cx * cx + cy * cy + cz * cz);
+
+    outCenter = mPosition;
+    outRadius = (offset + mBoundsRadius) * maxScale;
 }
 
 void CModel::draw()
 {
+    updateMatrix();
     if (mDisplayList) {
+        t3d_segment_set(MODEL_MATRIX_SEGMENT_ID, getMatrix());
         rspq_block_run(mDisplayList);
     }
 }
@@ -47,13 +95,19 @@ void CModel::setColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
 void CModel::updateMatrix()
 {
     if (!mMatrixFP) return;
+
+    uint32_t bufferIdx = sFrameIndex % mMatrixCount;
+    uint32_t bufferBit = 1u << bufferIdx;
+    if (!(mMatrixDirtyMask & bufferBit)) return;
     
-    t3d_mat4fp_from_srt_euler(mMatrixFP,
+    t3d_mat4fp_from_srt_euler(&mMatrixFP[bufferIdx],
         (float[3]){mScale.x(), mScale.y(), mScale.z()},
         (float[3]){mRotation.x(), -mRotation.y(), mRotation.z()},
         (float[3]){mPosition.x(), mPosition.y(), mPosition.z()}
     );
+    mMatrixDirtyMask &= ~bufferBit;
     mDirty = false;
+    ++sMatrixRebuilds;
 }
 
 void CModel::buildDisplayList()
@@ -63,7 +117,7 @@ void CModel::buildDisplayList()
     }
 
     rspq_block_begin();
-    t3d_matrix_push(mMatrixFP);
+    t3d_matrix_push((const T3DMat4FP*)t3d_segment_placeholder(MODEL_MATRIX_SEGMENT_ID));
     rdpq_set_prim_color(RGBA32(mColor[0], mColor[1], mColor[2], mColor[3]));
     t3d_model_draw(mModel);
     t3d_matrix_pop(1);
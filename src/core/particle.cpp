@@ -1,10 +1,15 @@
 #include "particle.hpp"
+#include "viewport.hpp"
+#include "collision.hpp"
+#include "render_queue.hpp"
+#include "model.hpp"
 #include <cstdlib>
 #include <cmath>
 #include <libdragon.h>
 
-static bool sTpxInitialized = false;
-static int sTpxRefCount = 0;
+static constexpr uint32_t sLodSimStride[PARTICLE_LOD_LEVELS] = {1, 2, 4};
+static constexpr float sLodEmissionScale[PARTICLE_LOD_LEVELS] = {1.0f, 0.5f, 0.25f};
+static constexpr float sLodDrawScale[PARTICLE_LOD_LEVELS] = {1.0f, 0.5f, 0.25f};
 
 static float randFloat(float min, float max)
 {
@@ -17,34 +22,39 @@ CParticleEmitter::~CParticleEmitter()
     destroy();
 }
 
-void CParticleEmitter::init(uint32_t maxParticles, int matrixStackSize)
+void CParticleEmitter::init(uint32_t maxParticles)
 {
     if (mInitialized) {
         destroy();
     }
 
     mMaxParticles = (maxParticles + 1) & ~1u;
+    mParticleLimit = mMaxParticles;
 
-    if (!sTpxInitialized) {
-        tpx_init({.matrixStackSize = matrixStackSize});
-        sTpxInitialized = true;
-    }
-    ++sTpxRefCount;
+    mNumBuffers = display_get_num_buffers();
 
-    mParticleBuffer = static_cast<TPXParticle*>(
-        malloc_uncached(sizeof(TPXParticle) * (mMaxParticles / 2))
+    mParticleBuffers = static_cast<TPXParticle*>(
+        malloc_uncached(sizeof(TPXParticle) * (mMaxParticles / 2) * mNumBuffers)
     );
 
-    mMatrixFP = static_cast<T3DMat4FP*>(malloc_uncached(sizeof(T3DMat4FP)));
-    t3d_mat4fp_identity(mMatrixFP);
+    mBufferedMatrices = static_cast<T3DMat4FP*>(malloc_uncached(sizeof(T3DMat4FP) * mNumBuffers));
+    for (uint32_t i = 0; i < mNumBuffers; ++i) {
+        t3d_mat4fp_identity(&mBufferedMatrices[i]);
+    }
+    mMatrixDirtyMask = ~0u;
+
+    mCustomColorLut = false;
+    mCustomSizeLut = false;
+    buildDefaultColorLut();
+    buildDefaultSizeLut();
 
     mParticles.resize(mMaxParticles);
     for (auto& p : mParticles) {
         p.active = false;
     }
 
-    for (uint32_t i = 0; i < mMaxParticles / 2; ++i) {
-        mParticleBuffer[i] = {};
+    for (uint32_t i = 0; i < (mMaxParticles / 2) * mNumBuffers; ++i) {
+        mParticleBuffers[i] = {};
     }
 
     mActiveCount = 0;
@@ -55,91 +65,123 @@ void CParticleEmitter::destroy()
 {
     if (!mInitialized) return;
 
-    if (mParticleBuffer) {
-        free_uncached(mParticleBuffer);
-        mParticleBuffer = nullptr;
+    if (mParticleBuffers) {
+        free_uncached(mParticleBuffers);
+        mParticleBuffers = nullptr;
     }
 
-    if (mMatrixFP) {
-        free_uncached(mMatrixFP);
-        mMatrixFP = nullptr;
+    if (mBufferedMatrices) {
+        free_uncached(mBufferedMatrices);
+        mBufferedMatrices = nullptr;
     }
+    mNumBuffers = 0;
 
     mParticles.clear();
 
-    --sTpxRefCount;
-    if (sTpxRefCount <= 0 && sTpxInitialized) {
-        tpx_destroy();
-        sTpxInitialized = false;
-        sTpxRefCount = 0;
-    }
-
     mInitialized = false;
     mActiveCount = 0;
 }
 
+void CParticleEmitter::tick(float dt)
+{
+    if (!mInitialized) return;
+
+    mSimAccumulator += dt;
+    mSimulated = false;
+
+    uint32_t stride = mCulled ? sLodSimStride[PARTICLE_LOD_LEVELS - 1] : mSimStride;
+    if (++mSimCounter >= stride) {
+        float simDt = mSimAccumulator;
+        mSimCounter = 0;
+        mSimAccumulator = 0.0f;
+        mSimulated = true;
+        update(simDt);
+    } else if (!mCulled) {
+        syncToBuffer();
+    }
+}
+
 void CParticleEmitter::update(float dt)
 {
     if (!mInitialized) return;
 
     mActiveCount = 0;
+    mBoundsMin = mPosition;
+    mBoundsMax = mPosition;
+
+    for (uint32_t s = 0; s < mSimSlices; ++s) {
+        mSliceTime[s] += dt;
+    }
+
+    uint32_t slice = mSliceCursor;
+    dt = mSliceTime[slice];
+    mSliceTime[slice] = 0.0f;
+    mSliceCursor = (mSliceCursor + 1) % mSimSlices;
 
     for (uint32_t i = 0; i < mMaxParticles; ++i) {
         CParticleData& p = mParticles[i];
         if (!p.active) continue;
 
-        p.life -= dt;
+        if (i % mSimSlices != slice) {
+            expandBounds(p);
+            ++mActiveCount;
+            continue;
+        }
+
+        // slice time accumulated before the particle was emitted does not apply to it
+        float stepDt = TMath<float>::max(dt - p.spawnOffset, 0.0f);
+        p.spawnOffset = 0.0f;
+
+        p.life -= stepDt;
         if (p.life <= 0.0f) {
             p.active = false;
             onParticleDeath(i);
             continue;
         }
 
-        p.velocity.x() += mGravity.x() * dt;
-        p.velocity.y() += mGravity.y() * dt;
-        p.velocity.z() += mGravity.z() * dt;
+        p.velocity.x() += mGravity.x() * stepDt;
+        p.velocity.y() += mGravity.y() * stepDt;
+        p.velocity.z() += mGravity.z() * stepDt;
 
-        p.position.x() += p.velocity.x() * dt;
-        p.position.y() += p.velocity.y() * dt;
-        p.position.z() += p.velocity.z() * dt;
+        p.position.x() += p.velocity.x() * stepDt;
+        p.position.y() += p.velocity.y() * stepDt;
+        p.position.z() += p.velocity.z() * stepDt;
 
-        float lifeRatio = p.life / p.maxLife;
-
-        if (mFadeOverLife) {
-            p.color[3] = static_cast<uint8_t>(255.0f * lifeRatio);
+        if (!onParticleMove(p)) {
+            p.active = false;
+            onParticleDeath(i);
+            continue;
         }
 
-        if (mShrinkOverLife) {
-            p.size = p.size * lifeRatio;
-        }
+        uint32_t lut = static_cast<uint32_t>((1.0f - p.life * p.invMaxLife) * (PARTICLE_LUT_SIZE - 1) + 0.5f);
+        const uint8_t* lutColor = mColorLut[lut];
+        p.color[0] = static_cast<uint8_t>((p.baseColor[0] * (lutColor[0] + 1)) >> 8);
+        p.color[1] = static_cast<uint8_t>((p.baseColor[1] * (lutColor[1] + 1)) >> 8);
+        p.color[2] = static_cast<uint8_t>((p.baseColor[2] * (lutColor[2] + 1)) >> 8);
+        p.color[3] = static_cast<uint8_t>((p.baseColor[3] * (lutColor[3] + 1)) >> 8);
+        p.size = p.baseSize * mSizeLut[lut];
 
+        expandBounds(p);
         ++mActiveCount;
     }
 
-    syncToBuffer();
+    if (!mCulled) {
+        syncToBuffer();
+    }
 }
 
-void CParticleEmitter::draw()
+void CParticleEmitter::drawBatched()
 {
-    if (!mInitialized || mActiveCount == 0) return;
-
-    rdpq_sync_pipe();
-    rdpq_sync_tile();
-    rdpq_set_mode_standard();
-    rdpq_mode_zbuf(true, true);
-    rdpq_mode_zoverride(true, 0, 0);
-    rdpq_mode_combiner(RDPQ_COMBINER1((PRIM,0,ENV,0), (0,0,0,PRIM)));
-    rdpq_set_env_color(RGBA32(255, 255, 255, 255));
-
-    tpx_state_from_t3d();
+    if (!mInitialized || !mVisible || mCulled || mActiveCount == 0) return;
 
-    tpx_matrix_push(mMatrixFP);
+    uint32_t bufferIdx = mFrameIndex % mNumBuffers;
+    tpx_matrix_push(&mBufferedMatrices[bufferIdx]);
 
     tpx_state_set_scale(mScaleX, mScaleY);
 
-    uint32_t drawCount = (mActiveCount + 1) & ~1u;
+    uint32_t drawCount = getDrawCount();
     if (drawCount > 0) {
-        tpx_particle_draw(mParticleBuffer, drawCount);
+        tpx_particle_draw(getFrameBuffer(mFrameIndex), drawCount);
     }
 
     tpx_matrix_pop(1);
@@ -158,12 +200,14 @@ int CParticleEmitter::emit(TVec3F const& position, TVec3F const& velocity,
     p.position = position;
     p.velocity = velocity;
     p.size = size;
+    p.baseSize = size;
     p.life = life;
-    p.maxLife = life;
-    p.color[0] = r;
-    p.color[1] = g;
-    p.color[2] = b;
-    p.color[3] = a;
+    p.invMaxLife = 1.0f / life;
+    p.spawnOffset = mSliceTime[idx % mSimSlices] + mSimAccumulator;
+    p.color[0] = p.baseColor[0] = r;
+    p.color[1] = p.baseColor[1] = g;
+    p.color[2] = p.baseColor[2] = b;
+    p.color[3] = p.baseColor[3] = a;
     p.active = true;
 
     ++mActiveCount;
@@ -175,25 +219,74 @@ void CParticleEmitter::burst(uint32_t count, TVec3F const& position, float sprea
                              float minSize, float maxSize,
                              float minLife, float maxLife,
                              uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+{
+    SParticleSpawnParams params{};
+    params.shape = EParticleSpawnShape::Box;
+    params.extent = {spread, spread, spread};
+    params.minVelocity = minVelocity;
+    params.maxVelocity = maxVelocity;
+    params.minSize = minSize;
+    params.maxSize = maxSize;
+    params.minLife = minLife;
+    params.maxLife = maxLife;
+    params.color[0] = r;
+    params.color[1] = g;
+    params.color[2] = b;
+    params.color[3] = a;
+
+    burst(count, position, params);
+}
+
+void CParticleEmitter::burst(uint32_t count, TVec3F const& position, SParticleSpawnParams const& params)
 {
     for (uint32_t i = 0; i < count; ++i) {
-        TVec3F pos = {
-            position.x() + randFloat(-spread, spread),
-            position.y() + randFloat(-spread, spread),
-            position.z() + randFloat(-spread, spread)
-        };
+        spawn(position, params);
+    }
+}
 
-        TVec3F vel = {
-            randFloat(minVelocity.x(), maxVelocity.x()),
-            randFloat(minVelocity.y(), maxVelocity.y()),
-            randFloat(minVelocity.z(), maxVelocity.z())
-        };
+void CParticleEmitter::spawn(TVec3F const& position, SParticleSpawnParams const& params)
+{
+    TVec3F offset{0.0f, 0.0f, 0.0f};
+
+    switch (params.shape) {
+        case EParticleSpawnShape::Sphere: {
+            float x, y, z;
+            do {
+                x = randFloat(-1.0f, 1.0f);
+                y = randFloat(-1.0f, 1.0f);
+                z = randFloat(-1.0f, 1.0f);
+            } while (x * x + y * y + z * z > 1.0f);
+            offset = {x * params.extent.x(), y * params.extent.y(), z * params.extent.z()};
+            break;
+        }
+        case EParticleSpawnShape::Box:
+            offset = {
+                randFloat(-params.extent.x(), params.extent.x()),
+                randFloat(-params.extent.y(), params.extent.y()),
+                randFloat(-params.extent.z(), params.extent.z())
+            };
+            break;
+        case EParticleSpawnShape::Point:
+        default:
+            break;
+    }
 
-        float size = randFloat(minSize, maxSize);
-        float life = randFloat(minLife, maxLife);
+    TVec3F pos = {
+        position.x() + offset.x(),
+        position.y() + offset.y(),
+        position.z() + offset.z()
+    };
 
-        emit(pos, vel, size, life, r, g, b, a);
-    }
+    TVec3F vel = {
+        randFloat(params.minVelocity.x(), params.maxVelocity.x()),
+        randFloat(params.minVelocity.y(), params.maxVelocity.y()),
+        randFloat(params.minVelocity.z(), params.maxVelocity.z())
+    };
+
+    float size = randFloat(params.minSize, params.maxSize);
+    float life = randFloat(params.minLife, params.maxLife);
+
+    emit(pos, vel, size, life, params.color[0], params.color[1], params.color[2], params.color[3]);
 }
 
 void CParticleEmitter::clear()
@@ -212,32 +305,119 @@ void CParticleEmitter::setScale(float scaleX, float scaleY)
 
 void CParticleEmitter::setPosition(TVec3F const& pos)
 {
+    if (pos == mPosition) return;
     mPosition = pos;
-    if (mMatrixFP) {
-        t3d_mat4fp_from_srt_euler(mMatrixFP,
-            (float[3]){mWorldScale, mWorldScale, mWorldScale},
-            (float[3]){0.0f, 0.0f, 0.0f},
-            (float[3]){pos.x(), pos.y(), pos.z()}
-        );
+    mMatrixDirtyMask = ~0u;
+}
+
+void CParticleEmitter::setColorLut(const uint8_t lut[PARTICLE_LUT_SIZE][4])
+{
+    for (int i = 0; i < PARTICLE_LUT_SIZE; ++i) {
+        mColorLut[i][0] = lut[i][0];
+        mColorLut[i][1] = lut[i][1];
+        mColorLut[i][2] = lut[i][2];
+        mColorLut[i][3] = lut[i][3];
+    }
+    mCustomColorLut = true;
+}
+
+void CParticleEmitter::setSizeLut(const float lut[PARTICLE_LUT_SIZE])
+{
+    for (int i = 0; i < PARTICLE_LUT_SIZE; ++i) {
+        mSizeLut[i] = lut[i];
+    }
+    mCustomSizeLut = true;
+}
+
+void CParticleEmitter::buildDefaultColorLut()
+{
+    for (int i = 0; i < PARTICLE_LUT_SIZE; ++i) {
+        float remaining = 1.0f - static_cast<float>(i) / (PARTICLE_LUT_SIZE - 1);
+
+        mColorLut[i][0] = 255;
+        mColorLut[i][1] = 255;
+        mColorLut[i][2] = 255;
+        mColorLut[i][3] = mFadeOverLife ? static_cast<uint8_t>(255.0f * remaining) : 255;
     }
 }
 
+void CParticleEmitter::buildDefaultSizeLut()
+{
+    for (int i = 0; i < PARTICLE_LUT_SIZE; ++i) {
+        float remaining = 1.0f - static_cast<float>(i) / (PARTICLE_LUT_SIZE - 1);
+        mSizeLut[i] = mShrinkOverLife ? remaining : 1.0f;
+    }
+}
+
+void CParticleEmitter::setSimulationSlices(uint32_t slices)
+{
+    mSimSlices = TMath<uint32_t>::clamp(slices, 1, PARTICLE_MAX_SIM_SLICES);
+    mSliceCursor = 0;
+    for (uint32_t s = 0; s < PARTICLE_MAX_SIM_SLICES; ++s) {
+        mSliceTime[s] = 0.0f;
+    }
+}
+
+void CParticleEmitter::expandBounds(CParticleData const& p)
+{
+    mBoundsMin.x() = TMath<float>::min(mBoundsMin.x(), p.position.x() - p.size);
+    mBoundsMin.y() = TMath<float>::min(mBoundsMin.y(), p.position.y() - p.size);
+    mBoundsMin.z() = TMath<float>::min(mBoundsMin.z(), p.position.z() - p.size);
+    mBoundsMax.x() = TMath<float>::max(mBoundsMax.x(), p.position.x() + p.size);
+    mBoundsMax.y() = TMath<float>::max(mBoundsMax.y(), p.position.y() + p.size);
+    mBoundsMax.z() = TMath<float>::max(mBoundsMax.z(), p.position.z() + p.size);
+}
+
+void CParticleEmitter::setLodLevel(int level)
+{
+    mLodLevel = TMath<int>::clamp(level, 0, PARTICLE_LOD_LEVELS - 1);
+    mSimStride = sLodSimStride[mLodLevel];
+    mEmissionScale = sLodEmissionScale[mLodLevel];
+    mDrawScale = sLodDrawScale[mLodLevel];
+}
+
+uint32_t CParticleEmitter::getDrawCount() const
+{
+    uint32_t count = static_cast<uint32_t>(mActiveCount * mDrawScale);
+    return (count + 1) & ~1u;
+}
+
+void CParticleEmitter::updateBufferedMatrix(uint32_t frameIndex)
+{
+    if (!mBufferedMatrices || mNumBuffers == 0) return;
+
+    uint32_t bufferIdx = frameIndex % mNumBuffers;
+    uint32_t bufferBit = 1u << bufferIdx;
+    if (!(mMatrixDirtyMask & bufferBit)) return;
+
+    t3d_mat4fp_from_srt_euler(&mBufferedMatrices[bufferIdx],
+        (float[3]){mWorldScale, mWorldScale, mWorldScale},
+        (float[3]){0.0f, 0.0f, 0.0f},
+        (float[3]){mPosition.x(), mPosition.y(), mPosition.z()}
+    );
+    mMatrixDirtyMask &= ~bufferBit;
+    CModel::countMatrixRebuild();
+}
+
 void CParticleEmitter::syncToBuffer()
 {
-    if (!mParticleBuffer) return;
+    if (!mParticleBuffers || mNumBuffers == 0) return;
+
+    TPXParticle* buffer = getFrameBuffer(mFrameIndex);
 
     uint32_t bufferIdx = 0;
     for (uint32_t i = 0; i < mMaxParticles && bufferIdx < mActiveCount; ++i) {
         CParticleData& p = mParticles[i];
         if (!p.active) continue;
 
-        int8_t* posPtr = tpx_buffer_get_pos(mParticleBuffer, bufferIdx);
-        int8_t* sizePtr = tpx_buffer_get_size(mParticleBuffer, bufferIdx);
-        uint8_t* colorPtr = tpx_buffer_get_rgba(mParticleBuffer, bufferIdx);
+        int8_t* posPtr = tpx_buffer_get_pos(buffer, bufferIdx);
+        int8_t* sizePtr = tpx_buffer_get_size(buffer, bufferIdx);
+        uint8_t* colorPtr = tpx_buffer_get_rgba(buffer, bufferIdx);
 
-        float relX = p.position.x() - mPosition.x();
-        float relY = p.position.y() - mPosition.y();
-        float relZ = p.position.z() - mPosition.z();
+        float pending = TMath<float>::max(mSliceTime[i % mSimSlices] + mSimAccumulator - p.spawnOffset, 0.0f);
+        float relX = p.position.x() + p.velocity.x() * pending - mPosition.x();
+        float relY = p.position.y() + p.velocity.y() * pending - mPosition.y();
+        float relZ = p.position.z() + p.velocity.z() * pending - mPosition.z();
 
         posPtr[0] = static_cast<int8_t>(TMath<float>::clamp(relX, -127.0f, 127.0f));
         posPtr[1] = static_cast<int8_t>(TMath<float>::clamp(relY, -127.0f, 127.0f));
@@ -254,14 +434,14 @@ void CParticleEmitter::syncToBuffer()
     }
 
     for (uint32_t i = bufferIdx; i < mMaxParticles; ++i) {
-        int8_t* sizePtr = tpx_buffer_get_size(mParticleBuffer, i);
+        int8_t* sizePtr = tpx_buffer_get_size(buffer, i);
         *sizePtr = 0;
     }
 }
 
 int CParticleEmitter::findFreeSlot()
 {
-    for (uint32_t i = 0; i < mMaxParticles; ++i) {
+    for (uint32_t i = 0; i < mParticleLimit; ++i) {
         if (!mParticles[i].active) {
             return static_cast<int>(i);
         }
@@ -272,38 +452,239 @@ int CParticleEmitter::findFreeSlot()
 void CContinuousEmitter::update(float dt)
 {
     if (mEmitting) {
-        mEmissionAccumulator += mEmissionRate * dt;
+        mEmissionAccumulator += mEmissionRate * mEmissionScale * dt;
 
         while (mEmissionAccumulator >= 1.0f) {
-            TVec3F pos = {
-                mPosition.x() + randFloat(-mSpawnSpread, mSpawnSpread),
-                mPosition.y() + randFloat(-mSpawnSpread, mSpawnSpread),
-                mPosition.z() + randFloat(-mSpawnSpread, mSpawnSpread)
-            };
+            spawn(mPosition, mSpawn);
+            mEmissionAccumulator -= 1.0f;
+        }
+    }
 
-            TVec3F vel = {
-                randFloat(mMinVelocity.x(), mMaxVelocity.x()),
-                randFloat(mMinVelocity.y(), mMaxVelocity.y()),
-                randFloat(mMinVelocity.z(), mMaxVelocity.z())
-            };
+    CParticleEmitter::update(dt);
+}
+
+void CContinuousEmitter::setSpawnColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+{
+    mSpawn.color[0] = r;
+    mSpawn.color[1] = g;
+    mSpawn.color[2] = b;
+    mSpawn.color[3] = a;
+}
 
-            float size = randFloat(mMinSize, mMaxSize);
-            float life = randFloat(mMinLife, mMaxLife);
+void CContinuousEmitter::setSpawnSpread(float spread)
+{
+    mSpawn.shape = EParticleSpawnShape::Box;
+    mSpawn.extent = {spread, spread, spread};
+}
+
+bool CSnowEmitter::onParticleMove(CParticleData& p)
+{
+    if (!mHeightGrid) return true;
 
-            emit(pos, vel, size, life, 
-                 mSpawnColor[0], mSpawnColor[1], mSpawnColor[2], mSpawnColor[3]);
+    float groundY;
+    if (!mHeightGrid->sampleHeight(p.position.x(), p.position.z(), &groundY)) return true;
+    if (p.position.y() > groundY) return true;
 
-            mEmissionAccumulator -= 1.0f;
+    if (mSettleTime <= 0.0f || p.position.y() < groundY - p.size * 2.0f - 1.0f) {
+        return false;
+    }
+
+    p.position.y() = groundY;
+    p.velocity = {0.0f, 0.0f, 0.0f};
+    if (p.life > mSettleTime) {
+        p.life = mSettleTime;
+    }
+    return true;
+}
+
+CParticleSystem& CParticleSystem::instance()
+{
+    static CParticleSystem system;
+    return system;
+}
+
+void CParticleSystem::init(uint32_t particleBudget, int matrixStackSize)
+{
+    if (mInitialized) {
+        destroy();
+    }
+
+    tpx_init({.matrixStackSize = matrixStackSize});
+
+    CRenderQueue::instance().setStateSetup(ERenderState::ParticleOpaque, []() { setupRenderState(EParticleRenderState::Opaque); });
+    CRenderQueue::instance().setStateSetup(ERenderState::ParticleAlpha, []() { setupRenderState(EParticleRenderState::Alpha); });
+
+    mBudget = particleBudget;
+    mAllocated = 0;
+    mEmitterCount = 0;
+    mInitialized = true;
+}
+
+void CParticleSystem::destroy()
+{
+    if (!mInitialized) return;
+
+    for (int i = 0; i < mEmitterCount; ++i) {
+        delete mEmitters[i];
+        mEmitters[i] = nullptr;
+    }
+    mEmitterCount = 0;
+    mAllocated = 0;
+
+    tpx_destroy();
+    mInitialized = false;
+}
+
+void CParticleSystem::destroyEmitter(CParticleEmitter* emitter)
+{
+    for (int i = 0; i < mEmitterCount; ++i) {
+        if (mEmitters[i] != emitter) continue;
+
+        delete emitter;
+        mEmitters[i] = mEmitters[mEmitterCount - 1];
+        mEmitters[mEmitterCount - 1] = nullptr;
+        --mEmitterCount;
+
+        allocateBudget();
+        return;
+    }
+}
+
+void CParticleSystem::setFrameIndex(uint32_t frameIndex)
+{
+    for (int i = 0; i < mEmitterCount; ++i) {
+        mEmitters[i]->setFrameIndex(frameIndex);
+    }
+}
+
+void CParticleSystem::update(float dt)
+{
+    mStats.culled = 0;
+    mStats.simulated = 0;
+
+    for (int i = 0; i < mEmitterCount; ++i) {
+        CParticleEmitter* emitter = mEmitters[i];
+        updateVisibility(emitter);
+        emitter->tick(dt);
+
+        if (emitter->isCulled()) {
+            mStats.culled += emitter->getActiveCount();
+        }
+        if (emitter->wasSimulated()) {
+            mStats.simulated += emitter->getActiveCount();
+        }
+    }
+}
+
+void CParticleSystem::updateVisibility(CParticleEmitter* emitter)
+{
+    if (!mViewport) {
+        emitter->setLodLevel(0);
+        emitter->setCulled(false);
+        return;
+    }
+
+    TVec3F const& cam = mViewport->getCameraPosition();
+    TVec3F const& pos = emitter->getPosition();
+    float dx = pos.x() - cam.x();
+    float dy = pos.y() - cam.y();
+    float dz = pos.z() - cam.z();
+    float distSq = dx * dx + dy * dy + dz * dz;
+
+    int level = 0;
+    if (distSq > emitter->getLodFar() * emitter->getLodFar()) {
+        level = 2;
+    } else if (distSq > emitter->getLodNear() * emitter->getLodNear()) {
+        level = 1;
+    }
+    emitter->setLodLevel(level);
+
+    if (emitter->getActiveCount() == 0) {
+        emitter->setCulled(!mViewport->isSphereVisible(pos, 1.0f));
+    } else {
+        emitter->setCulled(!mViewport->isAabbVisible(emitter->getBoundsMin(), emitter->getBoundsMax()));
+    }
+}
+
+void CParticleSystem::updateBufferedMatrix(uint32_t frameIndex)
+{
+    for (int i = 0; i < mEmitterCount; ++i) {
+        mEmitters[i]->updateBufferedMatrix(frameIndex);
+    }
+}
+
+void CParticleSystem::draw()
+{
+    mStats.drawn = 0;
+    if (!mInitialized) return;
+
+    CRenderQueue& queue = CRenderQueue::instance();
+    for (int i = 0; i < mEmitterCount; ++i) {
+        CParticleEmitter* emitter = mEmitters[i];
+        if (!emitter->isVisible() || emitter->isCulled() || emitter->getActiveCount() == 0) continue;
+
+        ERenderState state = emitter->getRenderState() == EParticleRenderState::Alpha ? ERenderState::ParticleAlpha : ERenderState::ParticleOpaque;
+        queue.submit(state, drawEmitter, emitter, queue.depthOf(emitter->getPosition()));
+        mStats.drawn += emitter->getDrawCount();
+    }
+}
+
+void CParticleSystem::drawEmitter(void* userData)
+{
+    static_cast<CParticleEmitter*>(userData)->drawBatched();
+}
+
+uint32_t CParticleSystem::getActiveCount() const
+{
+    uint32_t count = 0;
+    for (int i = 0; i < mEmitterCount; ++i) {
+        count += mEmitters[i]->getActiveCount();
+    }
+    return count;
+}
+
+void CParticleSystem::allocateBudget()
+{
+    CParticleEmitter* sorted[PARTICLE_SYSTEM_MAX_EMITTERS];
+    for (int i = 0; i < mEmitterCount; ++i) {
+        sorted[i] = mEmitters[i];
+    }
+
+    for (int i = 1; i < mEmitterCount; ++i) {
+        CParticleEmitter* emitter = sorted[i];
+        int j = i - 1;
+        while (j >= 0 && sorted[j]->getPriority() < emitter->getPriority()) {
+            sorted[j + 1] = sorted[j];
+            --j;
         }
+        sorted[j + 1] = emitter;
     }
 
-    CParticleEmitter::update(dt);
+    uint32_t remaining = mBudget;
+    for (int i = 0; i < mEmitterCount; ++i) {
+        uint32_t request = sorted[i]->getMaxParticles();
+        uint32_t granted = request < remaining ? request : remaining;
+        sorted[i]->setParticleLimit(granted);
+        remaining -= granted;
+    }
+
+    mAllocated = mBudget - remaining;
 }
 
-void CContinuousEmitter::setSpawnColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+void CParticleSystem::setupRenderState(EParticleRenderState state)
 {
-    mSpawnColor[0] = r;
-    mSpawnColor[1] = g;
-    mSpawnColor[2] = b;
-    mSpawnColor[3] = a;
-}
\ No newline at end of file
+    rdpq_sync_tile();
+    rdpq_set_mode_standard();
+    rdpq_mode_zoverride(true, 0, 0);
+    rdpq_mode_combiner(RDPQ_COMBINER1((PRIM,0,ENV,0), (0,0,0,PRIM)));
+    rdpq_set_env_color(RGBA32(255, 255, 255, 255));
+
+    if (state == EParticleRenderState::Alpha) {
+        rdpq_mode_zbuf(true, false);
+        rdpq_mode_blender(RDPQ_BLENDER_MULTIPLY);
+    } else {
+        rdpq_mode_zbuf(true, true);
+    }
+
+    tpx_state_from_t3d();
+}
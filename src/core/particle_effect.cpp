@@ -0,0 +1,79 @@
+#include "particle_effect.hpp"
+#include <cstring>
+
+bool CParticleEffect::load(const char* path)
+{
+    mLoaded = false;
+
+    FILE* file = asset_fopen(path, nullptr);
+    if (!file) {
+        debugf("Failed to open particle effect: %s\n", path);
+        return false;
+    }
+
+    SPfxHeader header{};
+    size_t read = fread(&header, sizeof(SPfxHeader), 1, file);
+    fclose(file);
+
+    if (read != 1 || memcmp(header.magic, "PFX1", 4) != 0) {
+        debugf("Invalid particle effect file: %s\n", path);
+        return false;
+    }
+
+    mMaxParticles = header.maxParticles;
+    mBurstCount = header.burstCount;
+    mEmissionRate = header.emissionRate;
+    mWorldScale = header.worldScale;
+    mContinuous = (header.flags & PFX_FLAG_CONTINUOUS) != 0;
+    mRenderState = header.renderState < static_cast<uint8_t>(EParticleRenderState::Count)
+        ? static_cast<EParticleRenderState>(header.renderState)
+        : EParticleRenderState::Opaque;
+    mGravity = {header.gravity[0], header.gravity[1], header.gravity[2]};
+
+    mSpawn.shape = header.spawnShape <= static_cast<uint8_t>(EParticleSpawnShape::Box)
+        ? static_cast<EParticleSpawnShape>(header.spawnShape)
+        : EParticleSpawnShape::Point;
+    mSpawn.extent = {header.extent[0], header.extent[1], header.extent[2]};
+    mSpawn.minVelocity = {header.minVelocity[0], header.minVelocity[1], header.minVelocity[2]};
+    mSpawn.maxVelocity = {header.maxVelocity[0], header.maxVelocity[1], header.maxVelocity[2]};
+    mSpawn.minSize = header.minSize;
+    mSpawn.maxSize = header.maxSize;
+    mSpawn.minLife = header.minLife;
+    mSpawn.maxLife = header.maxLife;
+    memcpy(mSpawn.color, header.color, sizeof(mSpawn.color));
+
+    memcpy(mColorLut, header.colorLut, sizeof(mColorLut));
+    for (int i = 0; i < PARTICLE_LUT_SIZE; ++i) {
+        mSizeLut[i] = header.sizeLut[i] / PFX_SIZE_LUT_SCALE;
+    }
+
+    mLoaded = true;
+    return true;
+}
+
+void CParticleEffect::configure(CParticleEmitter& emitter) const
+{
+    if (!mLoaded) return;
+
+    emitter.setGravity(mGravity);
+    emitter.setWorldScale(mWorldScale);
+    emitter.setRenderState(mRenderState);
+    emitter.setColorLut(mColorLut);
+    emitter.setSizeLut(mSizeLut);
+}
+
+void CParticleEffect::configure(CContinuousEmitter& emitter) const
+{
+    if (!mLoaded) return;
+
+    configure(static_cast<CParticleEmitter&>(emitter));
+    emitter.setSpawnParams(mSpawn);
+    emitter.setEmissionRate(mEmissionRate);
+}
+
+void CParticleEffect::burst(CParticleEmitter& emitter, TVec3F const& position) const
+{
+    if (!mLoaded) return;
+
+    emitter.burst(mBurstCount, position, mSpawn);
+}
@@ -2,6 +2,7 @@
 #include "menu.hpp"
 #include "sound.hpp"
 #include "util.hpp"
+#include "asset_cache.hpp"
 #include "rdpq_mode.h"
 #include <cmath>
 #include <libdragon.h>
@@ -15,47 +16,33 @@ void CPlayer::init(TVec3F const& startPos)
 {
 	mPosition = startPos;
 	mPrevPos = startPos;
-	if (!mTailYaw) {
-		mTailYaw = new float[4];
-		mTailPitch = new float[4];
-		mTailRoll = new float[4];
-		mTailYawVel = new float[4];
-		mTailPitchVel = new float[4];
-		mTailRollVel = new float[4];
-		for (int i = 0; i < 4; ++i) {
-			mTailYaw[i] = 0.0f;
-			mTailPitch[i] = 0.0f;
-			mTailRoll[i] = 0.0f;
-			mTailYawVel[i] = 0.0f;
-			mTailPitchVel[i] = 0.0f;
-			mTailRollVel[i] = 0.0f;
-		}
-	}
-	for (int i = 0; i < 4; ++i) {
-		mTailIdx[i] = -1;
-	}
+	CSecondaryMotion::instance().removeChain(mTailChain);
+	mTailChain = SECONDARY_CHAIN_INVALID;
 	
 	mModel.load("rom:/snep.t3dm");
 	mModel.setScale({0.1f, 0.1f, 0.1f});
 	mModel.setPosition(mPosition);
-	mModel.createSkeleton();
+	mModel.createSkeleton(ANIM_CONTROLLER_LAYER_COUNT);
 	
-	mModel.addAnimation("idle", 0);
-	mModel.addAnimation("walk", 1);
-	mModel.addAnimation("run", 2);
-	mModel.addAnimation("prep", 2);
-	mModel.addAnimation("throw", 2);
-	mModel.addAnimation("hold", 2);
-	mModel.addAnimation("reel", 2);
+	mAnims.idle = mModel.addAnimation("idle", ANIM_CONTROLLER_BASE_LAYER);
+	mAnims.walk = mModel.addAnimation("walk", ANIM_CONTROLLER_MOVEMENT_LAYER);
+	mAnims.run = mModel.addAnimation("run", ANIM_CONTROLLER_ACTION_LAYER);
+	mAnims.prep = mModel.addAnimation("prep", ANIM_CONTROLLER_ACTION_LAYER);
+	mAnims.cast = mModel.addAnimation("throw", ANIM_CONTROLLER_ACTION_LAYER);
+	mAnims.hold = mModel.addAnimation("hold", ANIM_CONTROLLER_ACTION_LAYER);
+	mAnims.reel = mModel.addAnimation("reel", ANIM_CONTROLLER_ACTION_LAYER);
+	
+	mAnimEvents.load("rom:/snep.aevt");
+	mModel.bindAnimationEvents(mAnimEvents);
 	
 	mAnimController.init(&mModel);
-	mAnimController.setBaseAnimation("idle", {.loops = true, .speed = 1.0f});
-	mAnimController.setMovementAnimation("walk", {.loops = true, .speed = 1.0f});
-	mAnimController.registerAction("run", {.loops = true, .speed = 1.3f});
-	mAnimController.registerAction("prep", {.loops = false, .speed = 1.4f}); 
-	mAnimController.registerAction("throw", {.loops = false, .speed = 1.0f});
-	mAnimController.registerAction("hold", {.loops = true, .speed = 1.5f});
-	mAnimController.registerAction("reel", {.loops = true, .speed = 1.0f});
+	mAnimController.setBaseAnimation(mAnims.idle, {.loops = true, .speed = 1.0f});
+	mAnimController.setMovementAnimation(mAnims.walk, {.loops = true, .speed = 1.0f});
+	mAnimController.registerAction(mAnims.run, {.loops = true, .speed = 1.3f});
+	mAnimController.registerAction(mAnims.prep, {.loops = false, .speed = 1.4f}); 
+	mAnimController.registerAction(mAnims.cast, {.loops = false, .speed = 1.0f});
+	mAnimController.registerAction(mAnims.hold, {.loops = true, .speed = 1.5f});
+	mAnimController.registerAction(mAnims.reel, {.loops = true, .speed = 1.0f});
 	
 	mStateMachine.init(this, "idle"); 
 	
@@ -73,31 +60,52 @@ void CPlayer::init(TVec3F const& startPos)
 	mThrowIndicator.buildDisplayList();
 
 	mRodEquipped = false;
-	mRodRootBoneIdx = -1;
-	mRodTipBoneIdx = -1;
+	for (int& bone : mRodBones) {
+		bone = -1;
+	}
+	mRodTipSocket = SOCKET_HANDLE_INVALID;
 	
 	mBobber.load("rom:/bobber.t3dm");
 	mBobber.setScale({0.1f, 0.1f, 0.1f});
 	mBobber.buildDisplayList();
 
 	if (auto skel = mModel.getSkeleton()) {
-		mTailIdx[0] = t3d_skeleton_find_bone(skel, "tail0");
-		mTailIdx[1] = t3d_skeleton_find_bone(skel, "tail1");
-		mTailIdx[2] = t3d_skeleton_find_bone(skel, "tail2");
+		mModel.findBones(PLAYER_BONE_NAMES, static_cast<int>(EPlayerBone::Count), mBones);
 		
-		mHandBoneIdx = t3d_skeleton_find_bone(skel, "handR");
+		SSecondaryChainDef tailDef{};
+		tailDef.stiffness = 45.0f;
+		tailDef.damping = 3.0f;
+		tailDef.follow = 1.2f;
+		tailDef.maxVelocity = 8.0f;
+		tailDef.limits[0] = 0.5f;
+		tailDef.limits[1] = 0.8f;
+		tailDef.limits[2] = 0.4f;
+		mTailChain = CSecondaryMotion::instance().addChain(skel, &mBones[static_cast<int>(EPlayerBone::Tail0)], 3, tailDef);
 		
-		mChestBoneIdx = t3d_skeleton_find_bone(skel, "chest");
+		mHandSocket = mModel.addSocket("handR");
 	}
 	
-	int numVerts = FISHING_LINE_SEGMENTS + 1;
-	int numPacked = (numVerts + 1) / 2;
-	mLineVerts = (T3DVertPacked*)malloc_uncached(sizeof(T3DVertPacked) * numPacked * 2);
-	mLineMatFP = (T3DMat4FP*)malloc_uncached(sizeof(T3DMat4FP));
+	T3DQuat rodOffsetRot;
+	float rodOffsetEuler[3] = {0.0f, 0.5f, 2.4f};
+	t3d_quat_from_euler(&rodOffsetRot, rodOffsetEuler);
+	float rodOffsetScale[3] = {1.50f, 1.50f, 1.50f};
+	float rodOffsetPos[3] = {-4.0f, 50.0f, 0.0f};
+	t3d_mat4_from_srt(&mRodOffset, rodOffsetScale, rodOffsetRot.v, rodOffsetPos);
 	
-	T3DMat4 identityMat;
-	t3d_mat4_identity(&identityMat);
-	t3d_mat4_to_fixed(mLineMatFP, &identityMat);
+	if (!mLineVerts) {
+		mLineBufferCount = display_get_num_buffers();
+		mLineVerts = (T3DVertPacked*)malloc_uncached(sizeof(T3DVertPacked) * FISHING_LINE_VERT_STRIDE * mLineBufferCount);
+	}
+	if (!mLineMatFP) {
+		mLineMatFP = (T3DMat4FP*)malloc_uncached(sizeof(T3DMat4FP));
+	}
+	
+	CRenderQueue::instance().setStateSetup(ERenderState::Line, setupLineState);
+	
+	T3DMat4 lineMat;
+	t3d_mat4_identity(&lineMat);
+	t3d_mat4_scale(&lineMat, 1.0f / FISHING_LINE_VERT_SCALE, 1.0f / FISHING_LINE_VERT_SCALE, 1.0f / FISHING_LINE_VERT_SCALE);
+	t3d_mat4_to_fixed(mLineMatFP, &lineMat);
 }
 
 void CPlayer::update(float dt)
@@ -139,59 +147,40 @@ void CPlayer::update(float dt)
 	
 	mModel.setPosition(mPosition);
 	mModel.setRotation({0.0f, mRotY, 0.0f});
-	mModel.updateMatrix();
+	mModel.updateSockets();
 	
-	mShadow.setPosition(mPosition);
-	mShadow.setRotation({0.0f, mRotY, 0.0f});
-	mShadow.updateMatrix();
+	if (!mCollisionMesh) {
+		mShadow.setPosition(mPosition);
+		mShadow.setRotation({0.0f, mRotY, 0.0f});
+	}
 
 	if (mItemModelLoaded && mItemIsSkinned) {
 		float itemRot = getItemGetRotation();
 		mItemGetSkinnedModel.setPosition({0.0f, 0.0f, 0.0f});
 		mItemGetSkinnedModel.setRotation({0.0f, itemRot, 0.0f});
-		mItemGetSkinnedModel.updateMatrix();
 		
 		setSkeletonToIdentity(mItemGetSkinnedModel.getSkeleton());
 		mItemGetSkinnedModel.updateSkeleton();
 	}
 
-	if (mRodEquipped && mHandBoneIdx >= 0 && mRodRootBoneIdx >= 0) {
-		T3DSkeleton* playerSkel = mModel.getSkeleton();
+	int rodRoot = mRodBones[static_cast<int>(ERodBone::Root)];
+	const T3DMat4* handWorldMat = mModel.getSocketMatrix(mHandSocket);
+	if (mRodEquipped && handWorldMat && rodRoot >= 0) {
 		T3DSkeleton* rodSkel = mFishingRod.getSkeleton();
 		
-		if (playerSkel && rodSkel) {
-			T3DMat4& handMatrix = playerSkel->bones[mHandBoneIdx].matrix;
-			
-			T3DMat4 playerWorldMat;
-			float scale[3] = {0.1f, 0.1f, 0.1f};
-			float rot[3] = {0.0f, -mRotY, 0.0f};
-			float pos[3] = {mPosition.x(), mPosition.y(), mPosition.z()};
-			t3d_mat4_from_srt_euler(&playerWorldMat, scale, rot, pos);
-			
-			T3DMat4 handWorldMat;
-			t3d_mat4_mul(&handWorldMat, &playerWorldMat, &handMatrix);
-			
-			T3DQuat offsetQuat;
-			float offsetEuler[3] = {0.0f, 0.5f, 2.4f};
-			t3d_quat_from_euler(&offsetQuat, offsetEuler);
-			float offsetScale[3] = {1.50f, 1.50f, 1.50f};
-			float offsetPos[3] = {-4.0f, 50.0f, 0.0f};
-			T3DMat4 localOffset;
-			t3d_mat4_from_srt(&localOffset, offsetScale, offsetQuat.v, offsetPos);
-
-			T3DMat4 finalTransform;
-			t3d_mat4_mul(&finalTransform, &handWorldMat, &localOffset);
-			
-			mRodWorldMatrix = finalTransform;
+		if (rodSkel) {
+			t3d_mat4_mul(&mRodWorldMatrix, handWorldMat, &mRodOffset);
 
 			T3DMat4 identity;
 			t3d_mat4_identity(&identity);
-			rodSkel->bones[mRodRootBoneIdx].matrix = identity;
-			rodSkel->bones[mRodRootBoneIdx].hasChanged = 1;
+			rodSkel->bones[rodRoot].matrix = identity;
+			rodSkel->bones[rodRoot].hasChanged = 1;
 
-			mFishingRod.setBufferedMatrixFromMat4(&finalTransform);
+			mFishingRod.setBufferedMatrixFromMat4(&mRodWorldMatrix);
 
+			CSecondaryMotion::instance().apply(mRodChain);
 			mFishingRod.updateSkeleton();
+			mFishingRod.updateSockets(&mRodWorldMatrix);
 		}
 	}
 
@@ -268,6 +257,9 @@ void CPlayer::equipFishingRod(const char* modelPath)
 {
 	if (!modelPath || modelPath[0] == '\0') return;
 	
+	CSecondaryMotion::instance().removeChain(mRodChain);
+	mRodChain = SECONDARY_CHAIN_INVALID;
+	
 	mFishingRod.unload();
 	
 	mFishingRod.load(modelPath);
@@ -276,8 +268,22 @@ void CPlayer::equipFishingRod(const char* modelPath)
 	mFishingRod.buildSkinnedDisplayList();
 	
 	if (auto rodSkel = mFishingRod.getSkeleton()) {
-		mRodRootBoneIdx = t3d_skeleton_find_bone(rodSkel, "Root");
-		mRodTipBoneIdx = t3d_skeleton_find_bone(rodSkel, "Pole_3");
+		mFishingRod.findBones(ROD_BONE_NAMES, static_cast<int>(ERodBone::Count), mRodBones);
+		
+		T3DMat4 tipOffset;
+		t3d_mat4_identity(&tipOffset);
+		tipOffset.m[3][1] = 65.0f;
+		mRodTipSocket = mFishingRod.addSocket(ROD_BONE_NAMES[static_cast<int>(ERodBone::Pole3)], &tipOffset);
+		
+		SSecondaryChainDef rodDef{};
+		rodDef.stiffness = 80.0f;
+		rodDef.damping = 8.0f;
+		rodDef.follow = 1.0f;
+		rodDef.limits[0] = 0.35f;
+		rodDef.limits[1] = 0.2f;
+		rodDef.limits[2] = 0.35f;
+		rodDef.mode = ESecondaryApplyMode::FromRest;
+		mRodChain = CSecondaryMotion::instance().addChain(rodSkel, &mRodBones[static_cast<int>(ERodBone::Pole1)], 3, rodDef);
 	}
 	
 	mRodEquipped = true;
@@ -375,10 +381,9 @@ void CPlayer::applyCollision(CCollisionMesh& collision)
 	
 	mShadow.setPosition({shadowX, shadowY, shadowZ});
 	mShadow.setRotation({shadowPitch, 0.0f, shadowRoll});
-	mShadow.updateMatrix();
 }
 
-void CPlayer::playFootstepSound(float prevFrame, float currentFrame, float step1Frame, float step2Frame)
+void CPlayer::playFootstepSound(int foot)
 {
 	const char* step1 = "sstep1";
 	const char* step2 = "sstep2";
@@ -391,11 +396,28 @@ void CPlayer::playFootstepSound(float prevFrame, float currentFrame, float step1
 		step2 = "rstep2";
 	}
 	
-	if (prevFrame < step1Frame && currentFrame >= step1Frame) {
-		CSoundMgr::play(step1);
-	}
-	else if (prevFrame < step2Frame && currentFrame >= step2Frame) {
-		CSoundMgr::play(step2);
+	CSoundMgr::play(foot == 0 ? step1 : step2);
+}
+
+void CPlayer::handleAnimationEvents()
+{
+	SAnimEventRecord event;
+	while (mModel.popAnimationEvent(event)) {
+		switch (event.type) {
+			case EAnimEventType::Footstep:
+				if ((event.anim == mAnims.walk && mStateMachine.isInState("walk")) ||
+				    (event.anim == mAnims.run && mStateMachine.isInState("run"))) {
+					playFootstepSound(event.param);
+				}
+				break;
+			case EAnimEventType::ThrowRelease:
+				if (event.anim == mAnims.cast && mStateMachine.isInState("throw") && !mBobberFlying && !mBobberLanded) {
+					startBobberThrow();
+				}
+				break;
+			default:
+				break;
+		}
 	}
 }
 
@@ -421,13 +443,16 @@ void CPlayer::initializeSkinnedModelBuffers(CSkinnedModel& model)
 
 void CPlayer::draw()
 {
-	mModel.draw();
+	CRenderQueue& queue = CRenderQueue::instance();
+	float depth = queue.depthOf(mPosition);
+	
+	queue.submit(ERenderState::Opaque3D, CModel::drawCallback, &mModel, depth);
 	
 	if (mRodEquipped) {
-		mFishingRod.draw();
+		queue.submit(ERenderState::Opaque3D, CModel::drawCallback, &mFishingRod, depth);
 	}
 	
-	mShadow.draw();
+	queue.submit(ERenderState::Translucent3D, CModel::drawCallback, &mShadow, depth);
 	
 	if (mStateMachine.isInState("prep")) {
 		drawThrowIndicator();
@@ -511,12 +536,14 @@ void CPlayer::updateAnimations(float dt)
 	
 	mAnimController.update(dt);
 	
-	updateTailPhysics(dt);
+	handleAnimationEvents();
+	
+	updateSecondaryMotion(dt);
 	
 	mModel.updateSkeleton();
 }
 
-void CPlayer::updateTailPhysics(float dt)
+void CPlayer::updateSecondaryMotion(float dt)
 {
 	T3DSkeleton* skel = mModel.getSkeleton();
 	if (!skel || !skel->skeletonRef) return;
@@ -553,64 +580,15 @@ void CPlayer::updateTailPhysics(float dt)
 	
 	float desiredRoll = 0.0f;
 
-	const float stiffness = 45.0f;
-	const float damping   = 3.0f;
-	const float follow    = 1.2f;
-
-	float targetYaw = desiredYaw;
-	float targetPitch = desiredPitch;
-	float targetRoll = desiredRoll;
-
-	for (int i = 0; i < 3; ++i) {
-		int idx = mTailIdx[i];
-		if (idx < 0 || idx >= (int)skel->skeletonRef->boneCount) continue;
-
-		float errY = targetYaw - mTailYaw[i];
-		float errP = targetPitch - mTailPitch[i];
-		float errR = targetRoll - mTailRoll[i];
-		mTailYawVel[i]   += errY * stiffness * dt;
-		mTailPitchVel[i] += errP * stiffness * dt;
-		mTailRollVel[i]  += errR * stiffness * dt;
-
-		float dampFactor = 1.0f / (1.0f + damping * dt);
-		mTailYawVel[i]   *= dampFactor;
-		mTailPitchVel[i] *= dampFactor;
-		mTailRollVel[i]  *= dampFactor;
-
-		mTailYaw[i]   += mTailYawVel[i] * dt;
-		mTailPitch[i] += mTailPitchVel[i] * dt;
-		mTailRoll[i]  += mTailRollVel[i] * dt;
-
-		const float maxYaw = 0.8f;
-		const float maxPitch = 0.5f;
-		const float maxRoll = 0.4f;
-		if (mTailYaw[i] > maxYaw) mTailYaw[i] = maxYaw;
-		if (mTailYaw[i] < -maxYaw) mTailYaw[i] = -maxYaw;
-		if (mTailPitch[i] > maxPitch) mTailPitch[i] = maxPitch;
-		if (mTailPitch[i] < -maxPitch) mTailPitch[i] = -maxPitch;
-		if (mTailRoll[i] > maxRoll) mTailRoll[i] = maxRoll;
-		if (mTailRoll[i] < -maxRoll) mTailRoll[i] = -maxRoll;
-
-		const float maxVel = 8.0f;
-		if (mTailYawVel[i] > maxVel) mTailYawVel[i] = maxVel;
-		if (mTailYawVel[i] < -maxVel) mTailYawVel[i] = -maxVel;
-		if (mTailPitchVel[i] > maxVel) mTailPitchVel[i] = maxVel;
-		if (mTailPitchVel[i] < -maxVel) mTailPitchVel[i] = -maxVel;
-
-		float euler[3] = { mTailPitch[i], mTailYaw[i], mTailRoll[i] };
-		T3DQuat physicsRot;
-		t3d_quat_from_euler(&physicsRot, euler);
+	CSecondaryMotion& motion = CSecondaryMotion::instance();
+	motion.setTarget(mTailChain, desiredPitch, desiredYaw, desiredRoll);
+	motion.apply(mTailChain);
 
-		T3DQuat animRot = skel->bones[idx].rotation;
-		t3d_quat_mul(&skel->bones[idx].rotation, &animRot, &physicsRot);
-		skel->bones[idx].hasChanged = 1;
-
-		targetYaw   = mTailYaw[i] * follow;
-		targetPitch = mTailPitch[i] * follow;
-		targetRoll  = mTailRoll[i] * follow;
-	}
+	float rodBend = mStateMachine.isInState("reel") ? 0.3f : 0.0f;
+	motion.setTarget(mRodChain, rodBend, 0.0f, -rotVel * 0.05f);
 	
-	if (mStateMachine.isInState("run") && mChestBoneIdx >= 0 && mChestBoneIdx < (int)skel->skeletonRef->boneCount) {
+	int chestBone = mBones[static_cast<int>(EPlayerBone::Chest)];
+	if (mStateMachine.isInState("run") && chestBone >= 0) {
 		float chestTwist = -rotVel * 0.15f;
 		
 		const float maxChestTwist = 0.3f;
@@ -621,9 +599,9 @@ void CPlayer::updateTailPhysics(float dt)
 		T3DQuat chestTwistQuat;
 		t3d_quat_from_euler(&chestTwistQuat, chestEuler);
 		
-		T3DQuat animRot = skel->bones[mChestBoneIdx].rotation;
-		t3d_quat_mul(&skel->bones[mChestBoneIdx].rotation, &animRot, &chestTwistQuat);
-		skel->bones[mChestBoneIdx].hasChanged = 1;
+		T3DQuat animRot = skel->bones[chestBone].rotation;
+		t3d_quat_mul(&skel->bones[chestBone].rotation, &animRot, &chestTwistQuat);
+		skel->bones[chestBone].hasChanged = 1;
 	}
 }
 
@@ -637,29 +615,19 @@ void CPlayer::clampPosition()
 
 T3DVec3 CPlayer::getHandWorldPosition()
 {
-	T3DSkeleton* skel = mModel.getSkeleton();
-	if (!skel || mHandBoneIdx < 0 || mHandBoneIdx >= (int)skel->skeletonRef->boneCount) {
+	if (!mModel.isValidSocket(mHandSocket)) {
 		return (T3DVec3){{mPosition.x(), mPosition.y() + 5.0f, mPosition.z()}};
 	}
-
-	T3DBone& bone = skel->bones[mHandBoneIdx];
-	
-	float boneX = bone.matrix.m[3][0];
-	float boneY = bone.matrix.m[3][1];
-	float boneZ = bone.matrix.m[3][2];
 	
-	T3DMat4 modelMat;
-	float scale[3] = {0.125f, 0.125f, 0.125f};
-	float rot[3] = {0.0f, -mRotY, 0.0f};
-	float pos[3] = {mPosition.x(), mPosition.y(), mPosition.z()};
-	t3d_mat4_from_srt_euler(&modelMat, scale, rot, pos);
-	
-	T3DVec3 bonePos = {{boneX, boneY, boneZ}};
-	T3DVec4 worldPos4;
-	t3d_mat4_mul_vec3(&worldPos4, &modelMat, &bonePos);
-	
-	T3DVec3 worldPos = {{worldPos4.v[0], worldPos4.v[1], worldPos4.v[2]}};
-	return worldPos;
+	// the socket is built with the model's 0.1 draw scale; hand queries have always used 0.125
+	constexpr float HAND_SCALE_RATIO = 0.125f / 0.1f;
+	T3DVec3 socketPos = mModel.getSocketPosition(mHandSocket);
+	TVec3F const& origin = mModel.getPosition();
+	return (T3DVec3){{
+		origin.x() + (socketPos.v[0] - origin.x()) * HAND_SCALE_RATIO,
+		origin.y() + (socketPos.v[1] - origin.y()) * HAND_SCALE_RATIO,
+		origin.z() + (socketPos.v[2] - origin.z()) * HAND_SCALE_RATIO
+	}};
 }
 
 void CPlayer::updateFishingLine(float dt)
@@ -757,8 +725,7 @@ void CPlayer::drawFishingLine(CViewport& viewport, TVec3F const& cameraPos)
 	
 	uint32_t lineColor = 0x000000FF;
 	
-	constexpr float VERT_SCALE = 64.0f;
-	constexpr float INV_VERT_SCALE = 1.0f / VERT_SCALE;
+	T3DVertPacked* lineVerts = mLineVerts + (mCurrentFrameIndex % mLineBufferCount) * FISHING_LINE_VERT_STRIDE;
 	
 	for (int i = 0; i <= FISHING_LINE_SEGMENTS; ++i) {
 		T3DVec3& pt = mRopePoints[i];
@@ -780,21 +747,21 @@ void CPlayer::drawFishingLine(CViewport& viewport, TVec3F const& cameraPos)
 		perpZ *= LINE_HALF_WIDTH;
 		
 		int16_t leftPos[3] = {
-			(int16_t)((pt.v[0] - perpX) * VERT_SCALE),
-			(int16_t)(pt.v[1] * VERT_SCALE),
-			(int16_t)((pt.v[2] - perpZ) * VERT_SCALE)
+			(int16_t)((pt.v[0] - perpX) * FISHING_LINE_VERT_SCALE),
+			(int16_t)(pt.v[1] * FISHING_LINE_VERT_SCALE),
+			(int16_t)((pt.v[2] - perpZ) * FISHING_LINE_VERT_SCALE)
 		};
 		
 		int16_t rightPos[3] = {
-			(int16_t)((pt.v[0] + perpX) * VERT_SCALE),
-			(int16_t)(pt.v[1] * VERT_SCALE),
-			(int16_t)((pt.v[2] + perpZ) * VERT_SCALE)
+			(int16_t)((pt.v[0] + perpX) * FISHING_LINE_VERT_SCALE),
+			(int16_t)(pt.v[1] * FISHING_LINE_VERT_SCALE),
+			(int16_t)((pt.v[2] + perpZ) * FISHING_LINE_VERT_SCALE)
 		};
 		
 		T3DVec3 normVec = {{0.0f, 1.0f, 0.0f}};
 		uint16_t norm = t3d_vert_pack_normal(&normVec);
 		
-		mLineVerts[i] = (T3DVertPacked){
+		lineVerts[i] = (T3DVertPacked){
 			.posA = {leftPos[0], leftPos[1], leftPos[2]},
 			.normA = norm,
 			.posB = {rightPos[0], rightPos[1], rightPos[2]},
@@ -806,33 +773,30 @@ void CPlayer::drawFishingLine(CViewport& viewport, TVec3F const& cameraPos)
 		};
 	}
 	
-	rdpq_sync_pipe();
-	data_cache_hit_writeback(mLineVerts, sizeof(T3DVertPacked) * (FISHING_LINE_SEGMENTS + 1));
-	
-	T3DMat4 lineMat{};
-	t3d_mat4_identity(&lineMat);
-	t3d_mat4_scale(&lineMat, INV_VERT_SCALE, INV_VERT_SCALE, INV_VERT_SCALE);
-	t3d_mat4_to_fixed(mLineMatFP, &lineMat);
+	data_cache_hit_writeback(lineVerts, sizeof(T3DVertPacked) * (FISHING_LINE_SEGMENTS + 1));
 
-	rdpq_sync_pipe();
-	rdpq_mode_push();
+	CRenderQueue& queue = CRenderQueue::instance();
+	queue.submit(ERenderState::Line, drawLinePacket, this, queue.depthOf(mPosition));
+}
+
+void CPlayer::setupLineState()
+{
 	rdpq_mode_combiner(RDPQ_COMBINER_FLAT);
-	rdpq_sync_pipe();
-	rdpq_set_prim_color(RGBA32(0, 0, 0, 255));
-	rdpq_sync_pipe();
-	t3d_state_set_drawflags(T3D_FLAG_SHADED);
-	rdpq_sync_pipe();
 	rdpq_mode_zbuf(false, false);
-	rdpq_sync_pipe();
+	rdpq_set_prim_color(RGBA32(0, 0, 0, 255));
+}
+
+void CPlayer::drawLinePacket(void* player)
+{
+	CPlayer* self = static_cast<CPlayer*>(player);
+	T3DVertPacked* lineVerts = self->mLineVerts + (self->mCurrentFrameIndex % self->mLineBufferCount) * FISHING_LINE_VERT_STRIDE;
 	
-	t3d_matrix_push(mLineMatFP);
-	rdpq_sync_pipe();
+	t3d_state_set_drawflags(T3D_FLAG_SHADED);
 	
+	t3d_matrix_push(self->mLineMatFP);
 	int numVerts = (FISHING_LINE_SEGMENTS + 1) * 2;
-	t3d_vert_load(mLineVerts, 0, numVerts);
-	
+	t3d_vert_load(lineVerts, 0, numVerts);
 	t3d_matrix_pop(1);
-	rdpq_sync_pipe();
 	
 	for (int i = 0; i < FISHING_LINE_SEGMENTS; ++i) {
 		int v0 = i * 2;
@@ -840,18 +804,13 @@ void CPlayer::drawFishingLine(CViewport& viewport, TVec3F const& cameraPos)
 		int v2 = i * 2 + 2;
 		int v3 = i * 2 + 3;
 		
-		rdpq_sync_pipe();
 		t3d_tri_draw(v0, v1, v2);
 		t3d_tri_draw(v1, v3, v2);
 		t3d_tri_draw(v2, v1, v0);
 		t3d_tri_draw(v2, v3, v1);
-		rdpq_sync_pipe();
 	}
-	rdpq_mode_pop();
-	rdpq_sync_pipe();
 	
 	t3d_tri_sync();
-	rdpq_sync_pipe();
 }
 
 void CPlayer::updateThrowTarget()
@@ -884,36 +843,17 @@ void CPlayer::updateThrowTarget()
 void CPlayer::drawThrowIndicator()
 {
 	if (mThrowFloorResult.found) {
-		mThrowIndicator.draw();
+		CRenderQueue& queue = CRenderQueue::instance();
+		queue.submit(ERenderState::Translucent3D, CModel::drawCallback, &mThrowIndicator, queue.depthOf(mThrowIndicator.getPosition()));
 	}
 }
 
 T3DVec3 CPlayer::getRodTipWorldPosition()
 {
-	T3DSkeleton* rodSkel = mFishingRod.getSkeleton();
-	if (!rodSkel || mRodTipBoneIdx < 0) {
+	if (!mFishingRod.isValidSocket(mRodTipSocket)) {
 		return {{mPosition.x(), mPosition.y() + 5.0f, mPosition.z()}};
 	}
-	
-	T3DBone& bone = rodSkel->bones[mRodTipBoneIdx];
-	float boneX = bone.matrix.m[3][0];
-	float boneY = bone.matrix.m[3][1];
-	float boneZ = bone.matrix.m[3][2];
-	
-	float boneYAxisX = bone.matrix.m[1][0];
-	float boneYAxisY = bone.matrix.m[1][1];
-	float boneYAxisZ = bone.matrix.m[1][2];
-	
-	const float boneTipOffset = 65.0f;
-	boneX += boneYAxisX * boneTipOffset;
-	boneY += boneYAxisY * boneTipOffset;
-	boneZ += boneYAxisZ * boneTipOffset;
-	
-	T3DVec3 bonePos = {{boneX, boneY, boneZ}};
-	T3DVec4 worldPos4;
-	t3d_mat4_mul_vec3(&worldPos4, &mRodWorldMatrix, &bonePos);
-	
-	return {{worldPos4.v[0], worldPos4.v[1], worldPos4.v[2]}};
+	return mFishingRod.getSocketPosition(mRodTipSocket);
 }
 
 void CPlayer::startBobberThrow()
@@ -971,7 +911,8 @@ void CPlayer::updateBobber(float dt)
 void CPlayer::drawBobber()
 {
 	if (mBobberFlying || mBobberLanded) {
-		mBobber.draw();
+		CRenderQueue& queue = CRenderQueue::instance();
+		queue.submit(ERenderState::Opaque3D, CModel::drawCallback, &mBobber, queue.depthOf(mBobberPos));
 	}
 }
 
@@ -1011,7 +952,7 @@ void CPlayer::drawItemGetOverlay(int fontId)
 	
 	static sprite_t* itmgetSprite = nullptr;
 	if (!itmgetSprite) {
-		itmgetSprite = sprite_load("rom:/itmget.rgba32.sprite");
+		itmgetSprite = CAssetCache::instance().acquireSprite("rom:/itmget.rgba32.sprite");
 	}
 	
 	if (itmgetSprite) {
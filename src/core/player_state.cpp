@@ -143,12 +143,6 @@ std::string CPlayerWalkState::update(CPlayer* player, float dt)
     player->getAnimController().setBlendFactor(blend);
     player->getAnimController().setMovementSpeed(blend + 0.8f);
     
-    float currentFrame = player->getModel().getAnimationFrame("walk");
-    float prevFrame = player->getPrevWalkFrame();
-    
-    player->playFootstepSound(prevFrame, currentFrame, 2.0f, 40.0f);
-    player->setPrevWalkFrame(currentFrame);
-    
     return "";
 }
 
@@ -158,7 +152,7 @@ void CPlayerWalkState::exit(CPlayer* player)
 
 void CPlayerRunState::init(CPlayer* player)
 {
-    player->getAnimController().playAction("run");
+    player->getAnimController().playAction(player->getAnims().run);
     player->getAnimController().holdAction(true);
 }
 
@@ -177,13 +171,6 @@ std::string CPlayerRunState::update(CPlayer* player, float dt)
     
     player->setSpeedMultiplier(3.0f);
     
-    float currentFrame = player->getModel().getAnimationFrame("run");
-    float prevFrame = player->getPrevRunFrame();
-    
-    player->playFootstepSound(prevFrame, currentFrame, 5.0f, 23.0f);
-    
-    player->setPrevRunFrame(currentFrame);
-    
     return "";
 }
 
@@ -195,7 +182,7 @@ void CPlayerRunState::exit(CPlayer* player)
 
 void CPlayerPrepState::init(CPlayer* player)
 {
-    player->getAnimController().playAction("prep");
+    player->getAnimController().playAction(player->getAnims().prep);
     player->getAnimController().holdAction(true);
     player->setThrowDistance(15.0f);
     player->updateThrowTarget();
@@ -261,9 +248,9 @@ void CPlayerPrepState::exit(CPlayer* player)
 
 void CPlayerThrowState::init(CPlayer* player)
 {
-    player->getAnimController().playAction("throw");
+    player->getAnimController().playAction(player->getAnims().cast);
     player->getAnimController().holdAction(true);
-    player->startBobberThrow();
+    player->resetBobber();
 }
 
 std::string CPlayerThrowState::update(CPlayer* player, float dt)
@@ -285,6 +272,9 @@ std::string CPlayerThrowState::update(CPlayer* player, float dt)
     }
     
     if (player->getAnimController().isActionFinished()) {
+        if (!player->isBobberFlying() && !player->hasBobberLanded()) {
+            player->startBobberThrow();
+        }
         return "hold";
     }
     
@@ -298,7 +288,8 @@ void CPlayerThrowState::exit(CPlayer* player)
 
 void CPlayerHoldState::init(CPlayer* player)
 {
-    player->getAnimController().playActionSeamless("hold");
+    player->getAnimController().setActionMask(PLAYER_UPPER_BODY_BONE);
+    player->getAnimController().playActionSeamless(player->getAnims().hold);
     
     mWaitTimer = 0.0f;
     
@@ -350,6 +341,7 @@ void CPlayerHoldState::exit(CPlayer* player)
 {
     player->getAnimController().holdAction(false);
     player->getAnimController().stopAction();
+    player->getAnimController().clearActionMask();
 }
 
 void CPlayerReelState::selectRandomFish()
@@ -402,7 +394,8 @@ void CPlayerReelState::selectRandomFish()
 
 void CPlayerReelState::init(CPlayer* player)
 {
-    player->getAnimController().playAction("reel");
+    player->getAnimController().setActionMask(PLAYER_UPPER_BODY_BONE);
+    player->getAnimController().playAction(player->getAnims().reel);
     player->getAnimController().holdAction(true);
     
     CMenu* menu = player->getMenu();
@@ -485,6 +478,7 @@ void CPlayerReelState::exit(CPlayer* player)
 {
     player->getAnimController().holdAction(false);
     player->getAnimController().stopAction();
+    player->getAnimController().clearActionMask();
 }
 
 void CPlayerItemGetState::init(CPlayer* player)
@@ -0,0 +1,140 @@
+#include "render_queue.hpp"
+
+CRenderQueue& CRenderQueue::instance()
+{
+    static CRenderQueue sInstance;
+    return sInstance;
+}
+
+CRenderQueue::CRenderQueue()
+{
+    mTranslucent[static_cast<int>(ERenderState::Translucent3D)] = true;
+    mTranslucent[static_cast<int>(ERenderState::ParticleAlpha)] = true;
+    mTranslucent[static_cast<int>(ERenderState::Line)] = true;
+}
+
+void CRenderQueue::begin(TVec3F const& cameraPos)
+{
+    mCameraPos = cameraPos;
+    mCount = 0;
+    mCurrentState = ERenderState::Opaque3D;
+    mStats = mFrameStats;
+    mFrameStats = {};
+}
+
+void CRenderQueue::submit(ERenderState state, TRenderCallback draw, void* userData, float depth)
+{
+    if (draw == nullptr) return;
+
+    if (mCount >= RENDER_QUEUE_MAX_PACKETS) {
+        ++mFrameStats.dropped;
+        debugf("CRenderQueue: queue full, dropping packet\n");
+        return;
+    }
+
+    SRenderPacket& packet = mPackets[mCount];
+    packet.draw = draw;
+    packet.userData = userData;
+    packet.depth = depth;
+    packet.state = state;
+    packet.order = static_cast<uint16_t>(mCount);
+    ++mCount;
+}
+
+void CRenderQueue::flush()
+{
+    if (!mSorted) {
+        // submission order, for measuring the same frame without state sorting
+        for (int i = 0; i < mCount; ++i) {
+            applyState(mPackets[i].state);
+            mPackets[i].draw(mPackets[i].userData);
+        }
+        applyState(ERenderState::Opaque3D);
+        mFrameStats.packets += mCount;
+        mCount = 0;
+        return;
+    }
+
+    int opaqueCount = 0;
+    int translucentCount = 0;
+    for (int i = 0; i < mCount; ++i) {
+        if (mTranslucent[static_cast<int>(mPackets[i].state)]) {
+            mTranslucentOrder[translucentCount++] = static_cast<uint16_t>(i);
+        } else {
+            mOpaque[opaqueCount++] = static_cast<uint16_t>(i);
+        }
+    }
+
+    sortPackets(mOpaque, opaqueCount, false);
+    sortPackets(mTranslucentOrder, translucentCount, true);
+
+    for (int i = 0; i < opaqueCount; ++i) {
+        SRenderPacket& packet = mPackets[mOpaque[i]];
+        applyState(packet.state);
+        packet.draw(packet.userData);
+    }
+    for (int i = 0; i < translucentCount; ++i) {
+        SRenderPacket& packet = mPackets[mTranslucentOrder[i]];
+        applyState(packet.state);
+        packet.draw(packet.userData);
+    }
+    applyState(ERenderState::Opaque3D);
+
+    mFrameStats.packets += mCount;
+    mCount = 0;
+}
+
+float CRenderQueue::depthOf(TVec3F const& pos) const
+{
+    float dx = pos.x() - mCameraPos.x();
+    float dy = pos.y() - mCameraPos.y();
+    float dz = pos.z() - mCameraPos.z();
+    return dx * dx + dy * dy + dz * dz;
+}
+
+void CRenderQueue::sortPackets(uint16_t* indices, int count, bool backToFront)
+{
+    for (int i = 1; i < count; ++i) {
+        uint16_t index = indices[i];
+        const SRenderPacket& packet = mPackets[index];
+        int j = i - 1;
+
+        while (j >= 0) {
+            const SRenderPacket& other = mPackets[indices[j]];
+            bool before;
+            if (backToFront) {
+                before = packet.depth > other.depth;
+            } else if (packet.state != other.state) {
+                before = packet.state < other.state;
+            } else {
+                before = packet.depth < other.depth;
+            }
+            if (!before) break;
+
+            indices[j + 1] = indices[j];
+            --j;
+        }
+        indices[j + 1] = index;
+    }
+}
+
+void CRenderQueue::applyState(ERenderState state)
+{
+    if (state == mCurrentState) return;
+
+    rdpq_sync_pipe();
+    ++mFrameStats.syncs;
+
+    if (mSetups[static_cast<int>(mCurrentState)] != nullptr) {
+        rdpq_mode_pop();
+    }
+
+    TRenderStateSetup setup = mSetups[static_cast<int>(state)];
+    if (setup != nullptr) {
+        rdpq_mode_push();
+        setup();
+    }
+
+    mCurrentState = state;
+    ++mFrameStats.stateChanges;
+}
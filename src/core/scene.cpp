@@ -1,12 +1,17 @@
 #include "scene.hpp"
 #include "camera.hpp"
 #include "wipe.hpp"
+#include "render_queue.hpp"
+#include "asset_cache.hpp"
 #include <t3d/t3dmath.h>
 #include <cstring>
 #include <cmath>
 
 static CCircleWipe gSceneStarWipe;
 
+uint32_t CScene::sGenerationCounter = 0;
+CLinearArena* CSceneObject::sLodArena = nullptr;
+
 CSceneObject::~CSceneObject()
 {
     destroy();
@@ -15,6 +20,8 @@ CSceneObject::~CSceneObject()
 void CSceneObject::init(const SSceneObjectDef& def)
 {
     mName = def.name;
+    mNameHash = def.nameHash != 0 ? def.nameHash : HashUtil::fnv1a(def.name);
+    mModelPath = def.modelPath;
     mPosition = def.position;
     mRotation = def.rotation;
     mScale = def.scale;
@@ -29,8 +36,11 @@ void CSceneObject::init(const SSceneObjectDef& def)
             mSkinnedModel.setRotation(mRotation);
             mSkinnedModel.setScale(mScale);
             mSkinnedModel.createSkeleton();
-            mSkinnedModel.addAnimation(def.animationName, false);
+            TAnimHandle anim = mSkinnedModel.addAnimation(def.animationName, 0);
             mSkinnedModel.buildSkinnedDisplayList();
+            if (mSkinnedModel.bakeAnimation(anim)) {
+                mSkinnedModel.setBakedPlayback(true);
+            }
         } else {
             mIsAnimated = false;
             mModel.load(def.modelPath);
@@ -40,18 +50,130 @@ void CSceneObject::init(const SSceneObjectDef& def)
             mModel.updateMatrix();
             mModel.buildDisplayList();
         }
+
+        if (def.lod != nullptr) {
+            loadLod(def);
+        }
     }
 
     mLoaded = true;
 }
 
+void CSceneObject::loadLod(const SSceneObjectDef& def)
+{
+    mLodDef = def.lod;
+    mLodLevel = 0;
+    mLodMeshCount = 0;
+
+    for (int i = 0; i < SCENE_LOD_MAX_MESHES && mLodDef->modelPaths[i] != nullptr; i++) {
+        CModel* mesh = nullptr;
+        if (mIsAnimated) {
+            CSkinnedModel* skinned = sLodArena ? sLodArena->create<CSkinnedModel>() : nullptr;
+            if (!skinned) skinned = new CSkinnedModel();
+            skinned->load(mLodDef->modelPaths[i]);
+            skinned->setPosition(mPosition);
+            skinned->setRotation(mRotation);
+            skinned->setScale(mScale);
+            skinned->createSkeleton();
+            TAnimHandle anim = skinned->addAnimation(def.animationName, 0);
+            skinned->buildSkinnedDisplayList();
+            if (skinned->bakeAnimation(anim)) {
+                skinned->setBakedPlayback(true);
+            }
+            mesh = skinned;
+        } else {
+            CModel* model = sLodArena ? sLodArena->create<CModel>() : nullptr;
+            if (!model) model = new CModel();
+            model->load(mLodDef->modelPaths[i]);
+            model->setPosition(mPosition);
+            model->setRotation(mRotation);
+            model->setScale(mScale);
+            model->buildDisplayList();
+            mesh = model;
+        }
+        mLodMeshInArena[mLodMeshCount] = sLodArena && sLodArena->contains(mesh);
+        mLodMeshes[mLodMeshCount++] = mesh;
+    }
+
+    if (mLodDef->impostorPath != nullptr) {
+        mImpostor = CAssetCache::instance().acquireSprite(mLodDef->impostorPath);
+        if (!mImpostor) {
+            debugf("CSceneObject: failed to load impostor %s\n", mLodDef->impostorPath);
+        }
+    }
+}
+
+void CSceneObject::unloadLod()
+{
+    for (int i = 0; i < mLodMeshCount; i++) {
+        if (mLodMeshInArena[i]) {
+            mLodMeshes[i]->~CModel();
+        } else {
+            delete mLodMeshes[i];
+        }
+        mLodMeshes[i] = nullptr;
+        mLodMeshInArena[i] = false;
+    }
+    mLodMeshCount = 0;
+    mLodLevel = 0;
+
+    if (mImpostor) {
+        CAssetCache::instance().releaseData(mImpostor);
+        mImpostor = nullptr;
+    }
+    mLodDef = nullptr;
+}
+
+float CSceneObject::getLodThreshold(int level) const
+{
+    return level < mLodMeshCount ? mLodDef->distances[level] : mLodDef->impostorDistance;
+}
+
+void CSceneObject::updateLod(const CViewport* viewport)
+{
+    if (!mLodDef || !viewport) return;
+
+    int maxLevel = mLodMeshCount + (mImpostor ? 1 : 0);
+    float hysteresis = mLodDef->hysteresis > 0.0f ? mLodDef->hysteresis : SCENE_LOD_DEFAULT_HYSTERESIS;
+
+    TVec3F cam = viewport->getCameraPosition();
+    float dx = mPosition.x() - cam.x();
+    float dy = mPosition.y() - cam.y();
+    float dz = mPosition.z() - cam.z();
+    float dist = sqrtf(dx * dx + dy * dy + dz * dz);
+
+    while (mLodLevel < maxLevel && dist > getLodThreshold(mLodLevel) * (1.0f + hysteresis)) {
+        ++mLodLevel;
+    }
+    while (mLodLevel > 0 && dist < getLodThreshold(mLodLevel - 1) * (1.0f - hysteresis)) {
+        --mLodLevel;
+    }
+}
+
+CModel* CSceneObject::getActiveModel()
+{
+    if (mLodLevel == 0) {
+        return mIsAnimated ? static_cast<CModel*>(&mSkinnedModel) : &mModel;
+    }
+    return mLodLevel <= mLodMeshCount ? mLodMeshes[mLodLevel - 1] : nullptr;
+}
+
+CSkinnedModel* CSceneObject::getActiveSkinnedModel()
+{
+    return mIsAnimated ? static_cast<CSkinnedModel*>(getActiveModel()) : nullptr;
+}
+
 void CSceneObject::update(float dt)
 {
     if (!mLoaded) return;
 
-    if (mIsAnimated) {
-        mSkinnedModel.updateAnimations(dt);
-        mSkinnedModel.updateSkeleton();
+    CSkinnedModel* skinned = getActiveSkinnedModel();
+    if (skinned) {
+        float animDt;
+        if (skinned->stepAnimationLod(dt, CSceneManager::instance().getViewport(), animDt)) {
+            skinned->updateAnimations(animDt);
+            skinned->updateSkeleton();
+        }
     }
 }
 
@@ -59,30 +181,83 @@ void CSceneObject::setFrameIndex(uint32_t frameIndex)
 {
     if (mIsAnimated) {
         mSkinnedModel.setFrameIndex(frameIndex);
+        for (int i = 0; i < mLodMeshCount; i++) {
+            static_cast<CSkinnedModel*>(mLodMeshes[i])->setFrameIndex(frameIndex);
+        }
     }
 }
 
 void CSceneObject::updateBufferedMatrix(uint32_t frameIndex)
+{
+    CSkinnedModel* skinned = getActiveSkinnedModel();
+    if (skinned) {
+        skinned->updateBufferedMatrix(frameIndex);
+    }
+}
+
+void CSceneObject::getBounds(TVec3F& outCenter, float& outRadius) const
 {
     if (mIsAnimated) {
-        mSkinnedModel.updateBufferedMatrix(frameIndex);
+        mSkinnedModel.getBoundingSphere(outCenter, outRadius);
+    } else {
+        mModel.getBoundingSphere(outCenter, outRadius);
     }
 }
 
+bool CSceneObject::updateVisibility(const CViewport* viewport)
+{
+    TVec3F center;
+    float radius;
+    getBounds(center, radius);
+    mVisible = viewport == nullptr || viewport->isSphereVisible(center, radius * SCENE_CULL_BOUNDS_PADDING);
+    return mVisible;
+}
+
 void CSceneObject::draw()
 {
     if (!mLoaded) return;
 
-    if (mIsAnimated) {
-        mSkinnedModel.draw();
-    } else if (mModel.getModel() != nullptr) {
-        mModel.draw();
+    CModel* model = getActiveModel();
+    if (model != nullptr && model->getModel() != nullptr) {
+        model->draw();
     }
 }
 
+void CSceneObject::setupImpostorState()
+{
+    rdpq_set_mode_standard();
+    rdpq_mode_alphacompare(1);
+    rdpq_mode_zbuf(true, false);
+}
+
+void CSceneObject::drawImpostor()
+{
+    CViewport* viewport = CSceneManager::instance().getViewport();
+    if (!mLoaded || !mImpostor || !viewport) return;
+
+    T3DVec3 base = {{mPosition.x(), mPosition.y(), mPosition.z()}};
+    T3DVec3 top = {{mPosition.x(), mPosition.y() + mLodDef->impostorHeight, mPosition.z()}};
+    T3DVec3 screenBase, screenTop;
+    t3d_viewport_calc_viewspace_pos(viewport->getViewport(), &screenBase, &base);
+    t3d_viewport_calc_viewspace_pos(viewport->getViewport(), &screenTop, &top);
+
+    float height = screenBase.v[1] - screenTop.v[1];
+    if (height < 1.0f || screenBase.v[2] <= 0.0f || screenBase.v[2] >= 1.0f) return;
+
+    float scale = height / mImpostor->height;
+    rdpq_blitparms_t params{};
+    params.scale_x = scale;
+    params.scale_y = scale;
+
+    rdpq_mode_zoverride(true, screenBase.v[2], 0);
+    rdpq_sprite_blit(mImpostor, screenBase.v[0] - mImpostor->width * scale * 0.5f, screenTop.v[1], &params);
+}
+
 void CSceneObject::destroy()
 {
+    unloadLod();
     mLoaded = false;
+    mBatched = false;
     mInteractionCallback = nullptr;
 }
 
@@ -110,30 +285,64 @@ void CSceneObject::triggerInteraction(CPlayer& player)
     }
 }
 
+CNpcObject::~CNpcObject()
+{
+    destroy();
+}
+
 void CNpcObject::init(const SSceneObjectDef& def)
 {
     CSceneObject::init(def);
     if (mIsAnimated) {
         T3DSkeleton* skel = mSkinnedModel.getSkeleton();
         if (skel) {
-            mHeadBoneIdx = t3d_skeleton_find_bone(skel, "Neck");
+            int headBone = t3d_skeleton_find_bone(skel, "Neck");
+            SSecondaryChainDef headDef{};
+            headDef.stiffness = 25.0f;
+            headDef.damping = 10.0f;
+            headDef.limits[0] = 1.2f;
+            headDef.limits[1] = 0.0f;
+            headDef.limits[2] = 0.0f;
+            mHeadChain = CSecondaryMotion::instance().addChain(skel, &headBone, 1, headDef);
+            if (mHeadChain == SECONDARY_CHAIN_INVALID) {
+                debugf("CNpcObject: %s has no head chain, look-at disabled\n", mName ? mName : "?");
+            }
         }
     }
 }
 
+void CNpcObject::destroy()
+{
+    CSecondaryMotion::instance().removeChain(mHeadChain);
+    mHeadChain = SECONDARY_CHAIN_INVALID;
+    CSceneObject::destroy();
+}
+
 void CNpcObject::update(float dt)
 {
     if (!mLoaded) return;
 
-    if (mIsAnimated) {
-        mSkinnedModel.updateMatrix();
-        mSkinnedModel.updateAnimations(dt);
-        
-        updateHeadLookAt(dt);
+    CSkinnedModel* skinned = getActiveSkinnedModel();
+    if (skinned) {
+        updateHeadLookAt();
 
-        mSkinnedModel.updateSkeleton();
-    } else {
-        mModel.updateMatrix();
+        if (mSkinnedModel.hasBakedAnimation()) {
+            TVec3F playerPos = CSceneManager::instance().getPlayer()->getPosition();
+            float headYaw = CSecondaryMotion::instance().getAngle(mHeadChain, 0, 0);
+            bool lookAtActive = mHeadChain != SECONDARY_CHAIN_INVALID && (checkPlayerInRange(playerPos) || fabsf(headYaw) > 0.01f);
+            mSkinnedModel.setBakedPlayback(!lookAtActive);
+        }
+
+        float animDt;
+        if (skinned->stepAnimationLod(dt, CSceneManager::instance().getViewport(), animDt)) {
+            skinned->updateAnimations(animDt);
+            
+            if (skinned == &mSkinnedModel && !mSkinnedModel.isBakedPlaybackActive()) {
+                CSecondaryMotion::instance().apply(mHeadChain);
+            }
+
+            skinned->updateSkeleton();
+        }
     }
 
     if (!CSceneManager::instance().isInConversation()) {
@@ -146,9 +355,9 @@ void CNpcObject::update(float dt)
     }
 }
 
-void CNpcObject::updateHeadLookAt(float dt)
+void CNpcObject::updateHeadLookAt()
 {
-    if (mHeadBoneIdx < 0) return;
+    if (mHeadChain == SECONDARY_CHAIN_INVALID) return;
 
     TVec3F playerPos = CSceneManager::instance().getPlayer()->getPosition();
     TVec3F headPos = {mPosition.x(), mPosition.y() + 30.0f, mPosition.z()};
@@ -165,21 +374,9 @@ void CNpcObject::updateHeadLookAt(float dt)
         
         while (targetYaw > T3D_PI) targetYaw -= 2.0f * T3D_PI;
         while (targetYaw < -T3D_PI) targetYaw += 2.0f * T3D_PI;
-
-        if (targetYaw > 1.2f) targetYaw = 1.2f;
-        if (targetYaw < -1.2f) targetYaw = -1.2f;
     }
 
-    mHeadYaw = t3d_lerp(mHeadYaw, targetYaw, 5.0f * dt);
-
-    T3DSkeleton* skel = mSkinnedModel.getSkeleton();
-    T3DQuat lookRot;
-    float euler[3] = {mHeadYaw, 0.0f, 0.0f};
-    t3d_quat_from_euler(&lookRot, euler);
-    
-    T3DQuat animRot = skel->bones[mHeadBoneIdx].rotation;
-    t3d_quat_mul(&skel->bones[mHeadBoneIdx].rotation, &animRot, &lookRot);
-    skel->bones[mHeadBoneIdx].hasChanged = 1;
+    CSecondaryMotion::instance().setTarget(mHeadChain, targetYaw, 0.0f, 0.0f);
 }
 
 void CNpcObject::draw()
@@ -187,63 +384,270 @@ void CNpcObject::draw()
     CSceneObject::draw();
 }
 
+CCrowdObject::~CCrowdObject()
+{
+    destroy();
+}
+
+void CCrowdObject::init(const SSceneObjectDef& def)
+{
+    SSceneObjectDef baseDef = def;
+    baseDef.modelPath = nullptr;
+    CSceneObject::init(baseDef);
+
+    mHandle = mCache.acquire(def.modelPath, def.animationName);
+    if (!mHandle.isValid()) return;
+
+    mNumBuffers = display_get_num_buffers();
+    mBufferedMatrices = CModel::allocMatrices(mNumBuffers, mMatricesInArena);
+    mBufferDirtyMask = ~0u;
+    for (uint32_t i = 0; i < mNumBuffers; ++i) {
+        updateBufferedMatrix(i);
+    }
+}
+
+void CCrowdObject::update(float dt)
+{
+    if (!mLoaded || !mHandle.isValid()) return;
+
+    if (!updateVisibility(CSceneManager::instance().getViewport())) {
+        mCache.markCulled();
+    } else {
+        mCache.requestPose(mHandle);
+    }
+}
+
+void CCrowdObject::updateBufferedMatrix(uint32_t frameIndex)
+{
+    if (!mBufferedMatrices || mNumBuffers == 0) return;
+
+    uint32_t bufferIdx = frameIndex % mNumBuffers;
+    uint32_t bufferBit = 1u << bufferIdx;
+    if (!(mBufferDirtyMask & bufferBit)) return;
+
+    t3d_mat4fp_from_srt_euler(
+        &mBufferedMatrices[bufferIdx],
+        (float[3]){mScale.x(), mScale.y(), mScale.z()},
+        (float[3]){mRotation.x(), -mRotation.y(), mRotation.z()},
+        (float[3]){mPosition.x(), mPosition.y(), mPosition.z()}
+    );
+    mBufferDirtyMask &= ~bufferBit;
+    CModel::countMatrixRebuild();
+}
+
+void CCrowdObject::getBounds(TVec3F& outCenter, float& outRadius) const
+{
+    float scale = fmaxf(mScale.x(), fmaxf(mScale.y(), mScale.z()));
+    outCenter = mPosition;
+    outRadius = mHandle.isValid() ? mCache.getBoundsRadius(mHandle) * scale : 0.0f;
+}
+
+void CCrowdObject::draw()
+{
+    if (!mLoaded || !mVisible || !mBufferedMatrices) return;
+
+    mCache.draw(mHandle, &mBufferedMatrices[mFrameIndex % mNumBuffers]);
+}
+
+void CCrowdObject::destroy()
+{
+    if (mHandle.isValid()) {
+        mCache.release(mHandle);
+        mHandle = {};
+    }
+    CModel::freeMatrices(mBufferedMatrices, mMatricesInArena);
+    mNumBuffers = 0;
+    CSceneObject::destroy();
+}
+
 CScene::~CScene()
 {
     exit();
 }
 
 void CScene::init(const SSceneDef& def, CPlayer& player, CViewport& viewport, CLight& light, CCamera& camera)
+{
+    beginLoad(def);
+    while (!loadStep(0)) {
+    }
+    activate(player, camera);
+}
+
+void CScene::beginLoad(const SSceneDef& def)
 {
     mDef = &def;
+    mObjectCount = 0;
+    mLoadStep = ESceneLoadStep::Map;
+
+    if (!mArena.isInitialized()) {
+        mArena.init(SCENE_ARENA_SIZE);
+    }
+    if (!mMatrixArena.isInitialized()) {
+        mMatrixArena.init(SCENE_MATRIX_ARENA_SIZE, true);
+    }
+    mArena.reset();
+    mArena.resetPeak();
+    mMatrixArena.reset();
+    mMatrixArena.resetPeak();
+    mLoadObjectIndex = 0;
+    mLoadStats = {};
+}
+
+bool CScene::loadStep(uint32_t budgetUs)
+{
+    if (mLoadStep == ESceneLoadStep::Idle || mLoadStep == ESceneLoadStep::Done) {
+        return mLoadStep == ESceneLoadStep::Done;
+    }
+
+    uint32_t frameStart = get_ticks_us();
+    ++mLoadStats.frames;
+    CModel::setMatrixArena(&mMatrixArena);
+    CSceneObject::setLodArena(&mArena);
+
+    do {
+        uint32_t stepStart = get_ticks_us();
+        const char* assetName = nullptr;
+
+        switch (mLoadStep) {
+            case ESceneLoadStep::Map: {
+                bool chunked = mDef->mapChunksPath != nullptr && mMapChunks.load(mDef->mapChunksPath);
+                if (!chunked && mDef->mapModelPath != nullptr) {
+                    mMapModel.load(mDef->mapModelPath);
+                    mMapModel.setScale({1.0f, 1.0f, 1.0f});
+                    mMapModel.setPosition({0.0f, 0.0f, 0.0f});
+                    mMapModel.updateMatrix();
+                    mMapModel.buildDisplayList();
+                }
+                assetName = chunked ? mDef->mapChunksPath : mDef->mapModelPath;
+                mLoadStep = ESceneLoadStep::Collision;
+                break;
+            }
+            case ESceneLoadStep::Collision:
+                if (mDef->collisionPath != nullptr) {
+                    mCollision.load(mDef->collisionPath);
+                    assetName = mDef->collisionPath;
+                }
+                mLoadStep = ESceneLoadStep::HeightGrid;
+                break;
+            case ESceneLoadStep::HeightGrid:
+                if (mCollision.isLoaded()) {
+                    mHeightGrid.build(mCollision);
+                    assetName = "height grid";
+                }
+                mLoadStep = ESceneLoadStep::Objects;
+                break;
+            case ESceneLoadStep::Objects: {
+                int count = mDef->objects != nullptr ? mDef->objectCount : 0;
+                if (count > SCENE_MAX_OBJECTS) count = SCENE_MAX_OBJECTS;
+                if (mLoadObjectIndex >= count) {
+                    mLoadStep = ESceneLoadStep::Done;
+                    break;
+                }
+
+                const SSceneObjectDef& objDef = mDef->objects[mLoadObjectIndex++];
+                CSceneObject* obj = createObject(objDef.type);
+                if (obj) {
+                    obj->init(objDef);
+                    mObjects[mObjectCount++] = obj;
+                }
+                assetName = objDef.modelPath != nullptr ? objDef.modelPath : objDef.name;
+                break;
+            }
+            default:
+                break;
+        }
+
+        if (assetName != nullptr && mLoadStats.entryCount < SCENE_LOAD_MAX_ENTRIES) {
+            SSceneLoadEntry& entry = mLoadStats.entries[mLoadStats.entryCount++];
+            entry.name = assetName;
+            entry.us = get_ticks_us() - stepStart;
+        }
+    } while (mLoadStep != ESceneLoadStep::Done && (budgetUs == 0 || get_ticks_us() - frameStart < budgetUs));
+
+    CModel::setMatrixArena(nullptr);
+    CSceneObject::setLodArena(nullptr);
+    mLoadStats.totalUs += get_ticks_us() - frameStart;
+    return mLoadStep == ESceneLoadStep::Done;
+}
+
+CSceneObject* CScene::createObject(ESceneObjectType type)
+{
+    CSceneObject* obj = nullptr;
 
-    if (def.mapModelPath != nullptr) {
-        mMapModel.load(def.mapModelPath);
-        mMapModel.setScale({1.0f, 1.0f, 1.0f});
-        mMapModel.setPosition({0.0f, 0.0f, 0.0f});
-        mMapModel.updateMatrix();
-        mMapModel.buildDisplayList();
+    switch (type) {
+        case ESceneObjectType::Npc:
+            obj = mArena.create<CNpcObject>();
+            if (!obj) obj = new CNpcObject();
+            break;
+        case ESceneObjectType::Crowd:
+            obj = mArena.create<CCrowdObject>(mCrowdCache);
+            if (!obj) obj = new CCrowdObject(mCrowdCache);
+            break;
+        case ESceneObjectType::Base:
+        default:
+            obj = mArena.create<CSceneObject>();
+            if (!obj) obj = new CSceneObject();
+            break;
+    }
+
+    if (!mArena.contains(obj)) {
+        debugf("CScene: arena full, object allocated from heap\n");
     }
+    return obj;
+}
 
-    if (def.collisionPath != nullptr) {
-        mCollision.load(def.collisionPath);
+void CScene::activate(CPlayer& player, CCamera& camera)
+{
+    if (mLoadStep != ESceneLoadStep::Done) return;
+
+    if (mCollision.isLoaded()) {
         camera.applyCollision(mCollision);
     }
 
-    player.init(def.playerSpawnPos);
-    player.setRotY(def.playerSpawnRotY);
+    player.init(mDef->playerSpawnPos);
+    player.setRotY(mDef->playerSpawnRotY);
     
-    camera.setOrbitAngle(def.playerSpawnRotY + T3D_PI);
+    camera.setOrbitAngle(mDef->playerSpawnRotY + T3D_PI);
 
-    mObjectCount = 0;
-    if (def.objects != nullptr && def.objectCount > 0) {
-        int count = def.objectCount;
-        if (count > SCENE_MAX_OBJECTS) count = SCENE_MAX_OBJECTS;
+    buildObjectRegistry();
 
-        for (int i = 0; i < count; i++) {
-            const SSceneObjectDef& objDef = def.objects[i];
-            CSceneObject* obj = nullptr;
-            
-            switch (objDef.type) {
-                case ESceneObjectType::Npc:
-                    obj = new CNpcObject();
-                    break;
-                case ESceneObjectType::Base:
-                default:
-                    obj = new CSceneObject();
-                    break;
-            }
-            
-            if (obj) {
-                obj->init(objDef);
-                mObjects[mObjectCount++] = obj;
-            }
+    mLoaded = true;
+    mLoadStep = ESceneLoadStep::Idle;
+
+    if (mDef->onInit != nullptr) {
+        mDef->onInit(*this);
+    }
+
+    buildStaticBatch();
+
+    debugf("CScene: loaded %s in %.2fms over %lu frames\n", mDef->name, mLoadStats.totalUs / 1000.0f, mLoadStats.frames);
+    for (int i = 0; i < mLoadStats.entryCount; i++) {
+        debugf("  %-32s %.2fms\n", mLoadStats.entries[i].name, mLoadStats.entries[i].us / 1000.0f);
+    }
+}
+
+void CScene::buildStaticBatch()
+{
+    mStaticBatch.clear();
+
+    for (int i = 0; i < mObjectCount; i++) {
+        CSceneObject* obj = mObjects[i];
+        if (obj->isStaticBatchable() && mStaticBatch.add(obj->getModel(), obj->getModelPath())) {
+            obj->setBatched(true);
         }
     }
 
-    mLoaded = true;
+    mStaticBatch.build();
+}
 
-    if (def.onInit != nullptr) {
-        def.onInit(*this);
+void CScene::unbatchMovedObjects()
+{
+    for (int i = 0; i < mObjectCount; i++) {
+        CSceneObject* obj = mObjects[i];
+        if (obj->isBatched() && obj->getModel()->isDirty()) {
+            mStaticBatch.remove(obj->getModel());
+            obj->setBatched(false);
+        }
     }
 }
 
@@ -251,6 +655,8 @@ void CScene::update(float dt, CPlayer& player)
 {
     if (!mLoaded || mDef == nullptr) return;
 
+    mCrowdCache.resetFrameStats();
+
     for (int i = 0; i < mObjectCount; i++) {
         mObjects[i]->update(dt);
         if (mObjects[i]->hasInteraction()) {
@@ -259,22 +665,66 @@ void CScene::update(float dt, CPlayer& player)
             }
         }
     }
+
+    mCrowdCache.update(dt);
+
     if (mDef->onUpdate != nullptr) {
         mDef->onUpdate(*this, dt);
     }
+
+    unbatchMovedObjects();
 }
 
 void CScene::draw()
 {
     if (!mLoaded) return;
 
-    mMapModel.draw();
+    mCullStats = {};
+
+    CRenderQueue& queue = CRenderQueue::instance();
+    queue.submit(ERenderState::Opaque3D, drawMap, this);
+    if (!mStaticBatch.isEmpty()) {
+        queue.submit(ERenderState::Opaque3D, drawStaticBatch, this);
+    }
 
     for (int i = 0; i < mObjectCount; i++) {
-        mObjects[i]->draw();
+        if (mObjects[i]->isBatched()) continue;
+        if (!mObjects[i]->isVisible()) {
+            ++mCullStats.culled;
+            continue;
+        }
+        if (mObjects[i]->isImpostor()) {
+            queue.submit(ERenderState::Impostor, CSceneObject::drawImpostorCallback, mObjects[i], queue.depthOf(mObjects[i]->getPosition()));
+        } else {
+            queue.submit(ERenderState::Opaque3D, CSceneObject::drawCallback, mObjects[i], queue.depthOf(mObjects[i]->getPosition()));
+        }
+        ++mCullStats.drawn;
+    }
+}
+
+void CScene::drawMap(void* scene)
+{
+    CScene* self = static_cast<CScene*>(scene);
+    CViewport* viewport = CSceneManager::instance().getViewport();
+
+    if (self->mMapChunks.isLoaded()) {
+        self->mMapChunks.draw(viewport, SCENE_FOG_FAR);
+        return;
+    }
+
+    TVec3F mapCenter;
+    float mapRadius;
+    self->mMapModel.getBoundingSphere(mapCenter, mapRadius);
+    if (viewport == nullptr || viewport->isSphereVisible(mapCenter, mapRadius)) {
+        self->mMapModel.draw();
     }
 }
 
+void CScene::drawStaticBatch(void* scene)
+{
+    static_cast<CScene*>(scene)->mStaticBatch.draw(CSceneManager::instance().getViewport());
+}
+
 void CScene::setFrameIndex(uint32_t frameIndex)
 {
     if (!mLoaded) return;
@@ -287,44 +737,120 @@ void CScene::setFrameIndex(uint32_t frameIndex)
 void CScene::updateBufferedMatrix(uint32_t frameIndex)
 {
     if (!mLoaded) return;
-    
+
+    CViewport* viewport = CSceneManager::instance().getViewport();
     for (int i = 0; i < mObjectCount; i++) {
-        mObjects[i]->updateBufferedMatrix(frameIndex);
+        if (mObjects[i]->isBatched()) continue;
+        mObjects[i]->updateLod(viewport);
+        if (mObjects[i]->updateVisibility(viewport)) {
+            mObjects[i]->updateBufferedMatrix(frameIndex);
+        }
     }
 }
 
 void CScene::exit()
 {
-    if (!mLoaded) return;
+    if (!mLoaded && mLoadStep == ESceneLoadStep::Idle) return;
 
-    if (mDef != nullptr && mDef->onExit != nullptr) {
+    if (mLoaded && mDef != nullptr && mDef->onExit != nullptr) {
         mDef->onExit(*this);
     }
 
     for (int i = 0; i < mObjectCount; i++) {
         if (mObjects[i]) {
             mObjects[i]->destroy();
-            delete mObjects[i];
+            if (mArena.contains(mObjects[i])) {
+                mObjects[i]->~CSceneObject();
+            } else {
+                delete mObjects[i];
+            }
             mObjects[i] = nullptr;
         }
     }
     mObjectCount = 0;
+    mRegistryCount = 0;
+    mGeneration = 0;
+    mCrowdCache.clear();
+    mStaticBatch.clear();
 
     mMapModel.unload();
+    mMapChunks.unload();
     mCollision.unload();
+    mHeightGrid.clear();
+
+    debugf("CScene: %s arena peak %lu/%lu, matrix arena peak %lu/%lu\n", mDef ? mDef->name : "?",
+           mArena.getPeak(), mArena.getCapacity(), mMatrixArena.getPeak(), mMatrixArena.getCapacity());
+    mArena.reset();
+    mMatrixArena.reset();
 
     mLoaded = false;
+    mLoadStep = ESceneLoadStep::Idle;
     mDef = nullptr;
 }
 
 CSceneObject* CScene::getObject(const char* name)
 {
+    CSceneObject* obj = getObject(HashUtil::fnv1a(name));
+    if (obj && obj->getName() != nullptr && strcmp(obj->getName(), name) == 0) {
+        return obj;
+    }
+    return nullptr;
+}
+
+CSceneObject* CScene::getObject(uint32_t nameHash)
+{
+    int index = findObjectIndex(nameHash);
+    return index >= 0 ? mObjects[index] : nullptr;
+}
+
+SSceneObjectHandle CScene::findObject(uint32_t nameHash) const
+{
+    int index = findObjectIndex(nameHash);
+    if (index < 0) return {};
+    return {index, mGeneration};
+}
+
+CSceneObject* CScene::resolve(SSceneObjectHandle handle) const
+{
+    if (!handle.isValid() || handle.generation != mGeneration || handle.index >= mObjectCount) {
+        return nullptr;
+    }
+    return mObjects[handle.index];
+}
+
+void CScene::buildObjectRegistry()
+{
+    mRegistryCount = 0;
     for (int i = 0; i < mObjectCount; i++) {
-        if (mObjects[i]->getName() != nullptr && strcmp(mObjects[i]->getName(), name) == 0) {
-            return mObjects[i];
+        uint32_t hash = mObjects[i]->getNameHash();
+        if (hash == 0) continue;
+
+        int j = mRegistryCount++;
+        while (j > 0 && mRegistryHashes[j - 1] > hash) {
+            mRegistryHashes[j] = mRegistryHashes[j - 1];
+            mRegistryIndices[j] = mRegistryIndices[j - 1];
+            --j;
         }
+        mRegistryHashes[j] = hash;
+        mRegistryIndices[j] = static_cast<uint8_t>(i);
     }
-    return nullptr;
+    mGeneration = ++sGenerationCounter;
+}
+
+int CScene::findObjectIndex(uint32_t nameHash) const
+{
+    int lo = 0;
+    int hi = mRegistryCount - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (mRegistryHashes[mid] == nameHash) return mRegistryIndices[mid];
+        if (mRegistryHashes[mid] < nameHash) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return -1;
 }
 
 CSceneObject* CScene::getObjectAt(int index)
@@ -363,6 +889,8 @@ void CSceneManager::init(CPlayer& player, CViewport& viewport, CLight& light, CC
     mInConversation = false;
     mInShop = false;
 
+    CRenderQueue::instance().setStateSetup(ERenderState::Impostor, CSceneObject::setupImpostorState);
+
     mTextBox.init(2, 20, 170, 216, 60);
     mTextBox.setBackgroundGradient(20, 20, 60, 200, 10, 10, 30, 220);
     mTextBox.setBorderColor(200, 200, 255, 255);
@@ -374,6 +902,8 @@ void CSceneManager::init(CPlayer& player, CViewport& viewport, CLight& light, CC
 
 void CSceneManager::update(float dt)
 {
+    CSkinnedModel::resetAnimLodStats();
+
     if (mInLogoScene) {
         mLogoScene.update(dt);
         
@@ -414,8 +944,11 @@ void CSceneManager::update(float dt)
         gSceneStarWipe.update(dt);
 
         if (mSceneTransitionState == ESceneTransitionState::StarWipeOut) {
-            if (gSceneStarWipe.isClosed()) {
-                if (mQueuedSceneDef != nullptr) {
+            bool preloaded = mNextScene == nullptr || mNextScene->loadStep(SCENE_LOAD_BUDGET_US);
+            if (gSceneStarWipe.isClosed() && preloaded) {
+                if (mNextScene != nullptr) {
+                    activateNextScene();
+                } else if (mQueuedSceneDef != nullptr) {
                     loadScene(*mQueuedSceneDef);
                 }
                 mQueuedSceneDef = nullptr;
@@ -595,6 +1128,13 @@ void CSceneManager::update(float dt)
     }
 }
 
+SSceneCullStats const& CSceneManager::getCullStats() const
+{
+    static const SSceneCullStats sEmpty{};
+    if (mInCutscene) return mCutscene.getCullStats();
+    return mCurrentScene != nullptr ? mCurrentScene->getCullStats() : sEmpty;
+}
+
 void CSceneManager::draw()
 {
     if (mInCutscene) {
@@ -604,6 +1144,7 @@ void CSceneManager::draw()
     }
 
     if (mInLogoScene) {
+        CRenderQueue::instance().flush();
         mLogoScene.draw();
     }
 }
@@ -752,6 +1293,19 @@ void CSceneManager::loadScene(const SSceneDef& def)
     mPlayer->freezeInput(1.0f);
 }
 
+void CSceneManager::activateNextScene()
+{
+    if (mCurrentScene != nullptr) {
+        mCurrentScene->exit();
+    }
+
+    mCurrentScene = mNextScene;
+    mNextScene = nullptr;
+    mCurrentScene->activate(*mPlayer, *mCamera);
+
+    mPlayer->freezeInput(1.0f);
+}
+
 void CSceneManager::transitionToSceneStar(const SSceneDef& def, float wipeOutDuration, float wipeInDuration)
 {
     if (mSceneTransitionState != ESceneTransitionState::None) return;
@@ -765,6 +1319,10 @@ void CSceneManager::transitionToSceneStar(const SSceneDef& def, float wipeOutDur
     }
 
     mQueuedSceneDef = &def;
+    if (mPlayer != nullptr && mViewport != nullptr && mLight != nullptr) {
+        mNextScene = mCurrentScene == &mSceneB ? &mSceneA : &mSceneB;
+        mNextScene->beginLoad(def);
+    }
     mSceneWipeOutDuration = wipeOutDuration;
     mSceneWipeInDuration = wipeInDuration;
     mSceneTransitionState = ESceneTransitionState::StarWipeOut;
@@ -782,19 +1340,19 @@ void CSceneManager::reloadCurrentScene()
 CLogoScene::~CLogoScene()
 {
     if (mN64Logo) {
-        sprite_free(mN64Logo);
+        CAssetCache::instance().releaseData(mN64Logo);
         mN64Logo = nullptr;
     }
     if (mZendenLogo) {
-        sprite_free(mZendenLogo);
+        CAssetCache::instance().releaseData(mZendenLogo);
         mZendenLogo = nullptr;
     }
 }
 
 void CLogoScene::init()
 {
-    if (!mN64Logo) mN64Logo = sprite_load("rom:/n64.sprite");
-    if (!mZendenLogo) mZendenLogo = sprite_load("rom:/zenden.sprite");
+    if (!mN64Logo) mN64Logo = CAssetCache::instance().acquireSprite("rom:/n64.sprite");
+    if (!mZendenLogo) mZendenLogo = CAssetCache::instance().acquireSprite("rom:/zenden.sprite");
     
     mState = ELogoState::StartWhite;
     mTimer = 1.0f;
@@ -934,18 +1492,27 @@ void CLogoScene::draw()
 CCutsceneScene::~CCutsceneScene()
 {
     exit();
-    if (mStaticModels != nullptr) {
-        delete[] mStaticModels;
-        mStaticModels = nullptr;
-    }
-    if (mSkinnedModels != nullptr) {
-        delete[] mSkinnedModels;
-        mSkinnedModels = nullptr;
+    releaseModels();
+}
+
+void CCutsceneScene::releaseModels()
+{
+    for (int i = 0; i < mModelCount; i++) {
+        mStaticModels[i].~CModel();
+        mSkinnedModels[i].~CSkinnedModel();
     }
-    if (mIsAnimated != nullptr) {
-        delete[] mIsAnimated;
-        mIsAnimated = nullptr;
+    mStaticModels = nullptr;
+    mSkinnedModels = nullptr;
+    mIsAnimated = nullptr;
+    mVisible = nullptr;
+    mModelCount = 0;
+
+    if (mArena.isInitialized()) {
+        debugf("CCutsceneScene: arena peak %lu/%lu, matrix arena peak %lu/%lu\n",
+               mArena.getPeak(), mArena.getCapacity(), mMatrixArena.getPeak(), mMatrixArena.getCapacity());
     }
+    mArena.reset();
+    mMatrixArena.reset();
 }
 
 void CCutsceneScene::init(const SCutsceneDef& def, CViewport& viewport, uint32_t frameIndex)
@@ -960,14 +1527,33 @@ void CCutsceneScene::init(const SCutsceneDef& def, CViewport& viewport, uint32_t
     mCurrentActionData = nullptr;
     mLastActionCheckTime = -1.0f;
     
+    releaseModels();
+
     if (def.objects != nullptr && def.objectCount > 0) {
-        mModelCount = def.objectCount;
-        mStaticModels = new CModel[mModelCount];
-        mSkinnedModels = new CSkinnedModel[mModelCount];
-        mIsAnimated = new bool[mModelCount];
+        int count = def.objectCount;
+        if (count > CUTSCENE_MAX_OBJECTS) {
+            debugf("CCutsceneScene: %d objects, only the first %d are loaded\n", count, CUTSCENE_MAX_OBJECTS);
+            count = CUTSCENE_MAX_OBJECTS;
+        }
+        if (!mArena.isInitialized() && !mArena.init(CUTSCENE_ARENA_SIZE)) {
+            return;
+        }
+        if (!mMatrixArena.isInitialized() && !mMatrixArena.init(CUTSCENE_MATRIX_ARENA_SIZE, true)) {
+            return;
+        }
+        mArena.resetPeak();
+        mMatrixArena.resetPeak();
+
+        mModelCount = count;
+        mStaticModels = mArena.createArray<CModel>(count);
+        mSkinnedModels = mArena.createArray<CSkinnedModel>(count);
+        mIsAnimated = mArena.createArray<bool>(count);
+        mVisible = mArena.createArray<bool>(count);
+        CModel::setMatrixArena(&mMatrixArena);
         
         for (int i = 0; i < mModelCount; i++) {
             const auto& objDef = def.objects[i];
+            mVisible[i] = true;
             
             if (objDef.modelPath != nullptr) {
                 if (objDef.animationName != nullptr) {
@@ -977,8 +1563,8 @@ void CCutsceneScene::init(const SCutsceneDef& def, CViewport& viewport, uint32_t
                     mSkinnedModels[i].setRotation(objDef.rotation);
                     mSkinnedModels[i].setScale(objDef.scale);
                     mSkinnedModels[i].createSkeleton();
-                    mSkinnedModels[i].addAnimation(objDef.animationName, 0);
-                    mSkinnedModels[i].playAnimation(objDef.animationName);
+                    TAnimHandle anim = mSkinnedModels[i].addAnimation(objDef.animationName, 0);
+                    mSkinnedModels[i].playAnimation(anim);
                     mSkinnedModels[i].setFrameIndex(frameIndex);
                     mSkinnedModels[i].updateBufferedMatrix(frameIndex);
                     mSkinnedModels[i].buildSkinnedDisplayList();
@@ -995,6 +1581,7 @@ void CCutsceneScene::init(const SCutsceneDef& def, CViewport& viewport, uint32_t
                 mIsAnimated[i] = false;
             }
         }
+        CModel::setMatrixArena(nullptr);
     }
     
     if (def.cameraFrames != nullptr && def.frameCount > 0) {
@@ -1023,13 +1610,6 @@ void CCutsceneScene::update(float dt)
     
     mTime += dt;
     
-    for (int i = 0; i < mModelCount; i++) {
-        if (mIsAnimated[i]) {
-            mSkinnedModels[i].updateAnimations(dt);
-            mSkinnedModels[i].updateSkeleton();
-        }
-    }
-    
     updateCamera(dt);
     
     if (mViewport != nullptr) {
@@ -1042,6 +1622,14 @@ void CCutsceneScene::update(float dt)
         mViewport->lookAt(mCameraPos, target);
     }
     
+    for (int i = 0; i < mModelCount; i++) {
+        float animDt;
+        if (mIsAnimated[i] && mSkinnedModels[i].stepAnimationLod(dt, mViewport, animDt)) {
+            mSkinnedModels[i].updateAnimations(animDt);
+            mSkinnedModels[i].updateSkeleton();
+        }
+    }
+    
     checkActions();
     
     if (mDef->frameCount > 0 && mCurrentFrameIndex >= mDef->frameCount) {
@@ -1110,13 +1698,18 @@ void CCutsceneScene::checkActions()
 void CCutsceneScene::draw()
 {
     if (!mLoaded) return;
-    
+
+    mCullStats = {};
+
+    CRenderQueue& queue = CRenderQueue::instance();
     for (int i = 0; i < mModelCount; i++) {
-        if (mIsAnimated[i]) {
-            mSkinnedModels[i].draw();
-        } else {
-            mStaticModels[i].draw();
+        if (!mVisible[i]) {
+            ++mCullStats.culled;
+            continue;
         }
+        CModel* model = mIsAnimated[i] ? static_cast<CModel*>(&mSkinnedModels[i]) : &mStaticModels[i];
+        queue.submit(ERenderState::Opaque3D, CModel::drawCallback, model, queue.depthOf(model->getPosition()));
+        ++mCullStats.drawn;
     }
 }
 
@@ -1127,6 +1720,8 @@ void CCutsceneScene::exit()
     if (mDef != nullptr && mDef->onEnd != nullptr) {
         mDef->onEnd();
     }
+
+    releaseModels();
     
     mLoaded = false;
     mDef = nullptr;
@@ -1144,12 +1739,24 @@ void CCutsceneScene::setFrameIndex(uint32_t frameIndex)
 void CCutsceneScene::updateBufferedMatrix(uint32_t frameIndex)
 {
     for (int i = 0; i < mModelCount; i++) {
-        if (mIsAnimated[i]) {
+        mVisible[i] = isModelVisible(i);
+        if (mIsAnimated[i] && mVisible[i]) {
             mSkinnedModels[i].updateBufferedMatrix(frameIndex);
         }
     }
 }
 
+bool CCutsceneScene::isModelVisible(int index) const
+{
+    const CModel& model = mIsAnimated[index] ? static_cast<const CModel&>(mSkinnedModels[index]) : mStaticModels[index];
+    if (mViewport == nullptr) return true;
+
+    TVec3F center;
+    float radius;
+    model.getBoundingSphere(center, radius);
+    return mViewport->isSphereVisible(center, radius * SCENE_CULL_BOUNDS_PADDING);
+}
+
 void CSceneManager::startLogoScene(const SCutsceneDef* nextCutscene)
 {
     mInLogoScene = true;
@@ -0,0 +1,178 @@
+#include "secondary_motion.hpp"
+#include <cmath>
+
+CSecondaryMotion& CSecondaryMotion::instance()
+{
+    static CSecondaryMotion sInstance;
+    return sInstance;
+}
+
+TSecondaryChain CSecondaryMotion::addChain(T3DSkeleton* skeleton, const int* bones, int boneCount, SSecondaryChainDef const& def)
+{
+    if (!skeleton || !skeleton->skeletonRef || !bones) return SECONDARY_CHAIN_INVALID;
+
+    TSecondaryChain chain = SECONDARY_CHAIN_INVALID;
+    for (int i = 0; i < SECONDARY_MOTION_MAX_CHAINS; ++i) {
+        if (!mChains[i].active) {
+            chain = i;
+            break;
+        }
+    }
+    if (chain == SECONDARY_CHAIN_INVALID) {
+        debugf("CSecondaryMotion: no free chain\n");
+        return SECONDARY_CHAIN_INVALID;
+    }
+
+    int first = mNodeCount;
+    for (int i = 0; i < boneCount; ++i) {
+        int bone = bones[i];
+        if (bone < 0 || bone >= (int)skeleton->skeletonRef->boneCount) continue;
+        if (mNodeCount >= SECONDARY_MOTION_MAX_NODES) {
+            debugf("CSecondaryMotion: node budget exceeded\n");
+            break;
+        }
+
+        int n = mNodeCount++;
+        for (int a = 0; a < 3; ++a) {
+            mAngle[a][n] = 0.0f;
+            mVelocity[a][n] = 0.0f;
+        }
+        mRest[n] = skeleton->bones[bone].rotation;
+        mBone[n] = bone;
+        mNodeChain[n] = chain;
+    }
+
+    if (mNodeCount == first) return SECONDARY_CHAIN_INVALID;
+
+    SChain& c = mChains[chain];
+    c.skeleton = skeleton;
+    c.def = def;
+    c.target[0] = c.target[1] = c.target[2] = 0.0f;
+    c.firstNode = first;
+    c.nodeCount = mNodeCount - first;
+    c.active = true;
+    ++mChainCount;
+    return chain;
+}
+
+void CSecondaryMotion::removeChain(TSecondaryChain chain)
+{
+    if (!isValidChain(chain)) return;
+
+    SChain& c = mChains[chain];
+    int first = c.firstNode;
+    int count = c.nodeCount;
+
+    for (int n = first + count; n < mNodeCount; ++n) {
+        int dst = n - count;
+        for (int a = 0; a < 3; ++a) {
+            mAngle[a][dst] = mAngle[a][n];
+            mVelocity[a][dst] = mVelocity[a][n];
+        }
+        mRest[dst] = mRest[n];
+        mBone[dst] = mBone[n];
+        mNodeChain[dst] = mNodeChain[n];
+    }
+    mNodeCount -= count;
+
+    for (int i = 0; i < SECONDARY_MOTION_MAX_CHAINS; ++i) {
+        if (mChains[i].active && mChains[i].firstNode > first) {
+            mChains[i].firstNode -= count;
+        }
+    }
+
+    c = {};
+    --mChainCount;
+}
+
+void CSecondaryMotion::clear()
+{
+    for (int i = 0; i < SECONDARY_MOTION_MAX_CHAINS; ++i) {
+        mChains[i] = {};
+    }
+    mChainCount = 0;
+    mNodeCount = 0;
+    mAccumulator = 0.0f;
+}
+
+void CSecondaryMotion::setTarget(TSecondaryChain chain, float a0, float a1, float a2)
+{
+    if (!isValidChain(chain)) return;
+
+    float* target = mChains[chain].target;
+    target[0] = a0;
+    target[1] = a1;
+    target[2] = a2;
+}
+
+float CSecondaryMotion::getAngle(TSecondaryChain chain, int node, int axis) const
+{
+    if (!isValidChain(chain) || node < 0 || node >= mChains[chain].nodeCount || axis < 0 || axis > 2) return 0.0f;
+    return mAngle[axis][mChains[chain].firstNode + node];
+}
+
+void CSecondaryMotion::update(float dt)
+{
+    if (!(dt > 0.0f) || mNodeCount == 0) return;
+
+    mAccumulator += dt;
+
+    int steps = 0;
+    while (mAccumulator >= SECONDARY_MOTION_STEP && steps < SECONDARY_MOTION_MAX_STEPS) {
+        step(SECONDARY_MOTION_STEP);
+        mAccumulator -= SECONDARY_MOTION_STEP;
+        ++steps;
+    }
+
+    if (mAccumulator >= SECONDARY_MOTION_STEP) {
+        mAccumulator = fmodf(mAccumulator, SECONDARY_MOTION_STEP);
+    }
+}
+
+void CSecondaryMotion::step(float h)
+{
+    float target[3]{};
+
+    for (int n = 0; n < mNodeCount; ++n) {
+        const SChain& chain = mChains[mNodeChain[n]];
+        const SSecondaryChainDef& def = chain.def;
+
+        for (int a = 0; a < 3; ++a) {
+            target[a] = n == chain.firstNode ? chain.target[a] : mAngle[a][n - 1] * def.follow;
+        }
+
+        float dampFactor = 1.0f / (1.0f + def.damping * h);
+
+        for (int a = 0; a < 3; ++a) {
+            float v = (mVelocity[a][n] + (target[a] - mAngle[a][n]) * def.stiffness * h) * dampFactor;
+            if (v > def.maxVelocity) v = def.maxVelocity;
+            if (v < -def.maxVelocity) v = -def.maxVelocity;
+
+            float x = mAngle[a][n] + v * h;
+            if (x > def.limits[a]) { x = def.limits[a]; v = 0.0f; }
+            if (x < -def.limits[a]) { x = -def.limits[a]; v = 0.0f; }
+
+            mAngle[a][n] = x;
+            mVelocity[a][n] = v;
+        }
+    }
+}
+
+void CSecondaryMotion::apply(TSecondaryChain chain)
+{
+    if (!isValidChain(chain)) return;
+
+    const SChain& c = mChains[chain];
+    T3DBone* bones = c.skeleton->bones;
+
+    for (int n = c.firstNode; n < c.firstNode + c.nodeCount; ++n) {
+        float euler[3] = {mAngle[0][n], mAngle[1][n], mAngle[2][n]};
+        T3DQuat physicsRot;
+        t3d_quat_from_euler(&physicsRot, euler);
+
+        T3DBone& bone = bones[mBone[n]];
+        T3DQuat baseRot = c.def.mode == ESecondaryApplyMode::FromRest ? mRest[n] : bone.rotation;
+        t3d_quat_mul(&bone.rotation, &baseRot, &physicsRot);
+        bone.hasChanged = 1;
+    }
+}
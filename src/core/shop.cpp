@@ -4,6 +4,7 @@
 #include "rdpq_text.h"
 #include "wipe.hpp"
 #include "save_manager.hpp"
+#include "asset_cache.hpp"
 #include <t3d/t3d.h>
 #include <cstring>
 #include <cmath>
@@ -13,7 +14,7 @@ static CWhiteFade gShopFade;
 CShop::~CShop()
 {
     if (mCursorSprite) {
-        sprite_free(mCursorSprite);
+        CAssetCache::instance().releaseData(mCursorSprite);
         mCursorSprite = nullptr;
     }
     
@@ -34,7 +35,7 @@ void CShop::init(int fontId)
     mPreviewModelLoaded = false;
     mCursorTimer = 0.0f;
 
-    mCursorSprite = sprite_load("rom:/sflk.ia16.sprite");
+    mCursorSprite = CAssetCache::instance().acquireSprite("rom:/sflk.ia16.sprite");
 
     mPreviewViewport.init();
     mPreviewViewport.setProjection(45.0f, 1.0f, 100.0f);
@@ -1,4 +1,76 @@
 #include "skinned_model.hpp"
+#include "viewport.hpp"
+#include "anim_clip_library.hpp"
+#include <cmath>
+#include <cstring>
+
+SAnimLodStats CSkinnedModel::sAnimLodStats{};
+uint32_t CSkinnedModel::sAnimBakeClipBudget = ANIM_BAKE_DEFAULT_CLIP_BUDGET;
+uint32_t CSkinnedModel::sAnimBakeTotalBudget = ANIM_BAKE_DEFAULT_TOTAL_BUDGET;
+uint32_t CSkinnedModel::sAnimBakeBytesUsed = 0;
+
+static constexpr uint32_t sAnimLodDivisors[ANIM_LOD_LEVELS] = {1, 2, 4};
+static uint32_t sAnimLodSeed = 0;
+
+static constexpr float ANIM_BAKE_ROTATION_ONE = 32767.0f;
+static constexpr float ANIM_BAKE_SCALE_ONE = 4096.0f;
+
+static int16_t quantise(float value, float one)
+{
+    float q = value * one;
+    q = TMath<float>::max(-32767.0f, TMath<float>::min(q, 32767.0f));
+    return static_cast<int16_t>(q < 0.0f ? q - 0.5f : q + 0.5f);
+}
+
+// splits a model-space bone matrix (m[column][row]) back into scale, rotation and translation
+static void packBakedBone(SBakedBone& out, const T3DMat4& mat, float positionUnit)
+{
+    float scale[3];
+    for (int c = 0; c < 3; ++c) {
+        scale[c] = sqrtf(mat.m[c][0] * mat.m[c][0] + mat.m[c][1] * mat.m[c][1] + mat.m[c][2] * mat.m[c][2]);
+        out.scale[c] = quantise(scale[c], ANIM_BAKE_SCALE_ONE);
+        out.position[c] = quantise(mat.m[3][c], 1.0f / positionUnit);
+    }
+
+    float r[3][3];
+    for (int c = 0; c < 3; ++c) {
+        float inv = scale[c] > 0.0f ? 1.0f / scale[c] : 0.0f;
+        for (int row = 0; row < 3; ++row) {
+            r[row][c] = mat.m[c][row] * inv;
+        }
+    }
+
+    float q[4];
+    float trace = r[0][0] + r[1][1] + r[2][2];
+    if (trace > 0.0f) {
+        float s = 0.5f / sqrtf(trace + 1.0f);
+        q[3] = 0.25f / s;
+        q[0] = (r[2][1] - r[1][2]) * s;
+        q[1] = (r[0][2] - r[2][0]) * s;
+        q[2] = (r[1][0] - r[0][1]) * s;
+    } else if (r[0][0] > r[1][1] && r[0][0] > r[2][2]) {
+        float s = 2.0f * sqrtf(1.0f + r[0][0] - r[1][1] - r[2][2]);
+        q[3] = (r[2][1] - r[1][2]) / s;
+        q[0] = 0.25f * s;
+        q[1] = (r[0][1] + r[1][0]) / s;
+        q[2] = (r[0][2] + r[2][0]) / s;
+    } else if (r[1][1] > r[2][2]) {
+        float s = 2.0f * sqrtf(1.0f + r[1][1] - r[0][0] - r[2][2]);
+        q[3] = (r[0][2] - r[2][0]) / s;
+        q[0] = (r[0][1] + r[1][0]) / s;
+        q[1] = 0.25f * s;
+        q[2] = (r[1][2] + r[2][1]) / s;
+    } else {
+        float s = 2.0f * sqrtf(1.0f + r[2][2] - r[0][0] - r[1][1]);
+        q[3] = (r[1][0] - r[0][1]) / s;
+        q[0] = (r[0][2] + r[2][0]) / s;
+        q[1] = (r[1][2] + r[2][1]) / s;
+        q[2] = 0.25f * s;
+    }
+    for (int i = 0; i < 4; ++i) {
+        out.rotation[i] = quantise(q[i], ANIM_BAKE_ROTATION_ONE);
+    }
+}
 
 CSkinnedModel::~CSkinnedModel()
 {
@@ -7,33 +79,40 @@ CSkinnedModel::~CSkinnedModel()
 
 void CSkinnedModel::unload()
 {
+    freeBakedAnimation();
     if (mHasSkeleton) {
         t3d_skeleton_destroy(&mSkeleton);
         mHasSkeleton = false;
     }
-    if (mHasBlendSkeleton) {
-        t3d_skeleton_destroy(&mSkeletonBlend);
-        mHasBlendSkeleton = false;
-    }
-    if (mHasActionSkeleton) {
-        t3d_skeleton_destroy(&mSkeletonAction);
-        mHasActionSkeleton = false;
+    if (mLayerPool) {
+        free(mLayerPool);
+        mLayerPool = nullptr;
     }
-    for (auto& [name, anim] : mAnimations) {
-        t3d_anim_destroy(&anim);
+    for (int i = 0; i < ANIM_MAX_LAYERS; ++i) {
+        mLayers[i] = {};
     }
-    mAnimations.clear();
-    if (mBufferedMatrices) {
-        free_uncached(mBufferedMatrices);
-        mBufferedMatrices = nullptr;
-        mNumBuffers = 0;
+    mLayerCount = 0;
+    mSocketCount = 0;
+    for (int i = 0; i < mAnimationCount; ++i) {
+        destroyAnimation(mAnimations[i]);
+        mAnimationNames[i].clear();
+        mAnimEventTracks[i] = nullptr;
+        mAnimEventCounts[i] = 0;
     }
+    mAnimEventQueue.clear();
+    mAnimationCount = 0;
+    CAnimClipLibrary::instance().releaseRig(mRig, mModel);
+    mRig = ANIM_RIG_INVALID;
+    mPath.clear();
+    freeMatrices(mBufferedMatrices, mBufferedInArena);
+    mNumBuffers = 0;
     CModel::unload();
 }
 
 void CSkinnedModel::load(std::string const& path)
 {
     CModel::load(path);
+    mPath = path;
 }
 
 void CSkinnedModel::draw()
@@ -41,12 +120,19 @@ void CSkinnedModel::draw()
     if (mHasSkeleton && mBufferedMatrices && mNumBuffers > 0) {
         uint32_t bufferIdx = mFrameIndex % mNumBuffers;
         t3d_segment_set(SKINNED_MODEL_SEGMENT_ID, &mBufferedMatrices[bufferIdx]);
-        t3d_skeleton_use(&mSkeleton);
+        if (mBakedPlayback) {
+            updateBakedPose();
+            t3d_segment_set(T3D_SEGMENT_SKELETON, &mBakedClip.pose[bufferIdx * mBakedClip.boneCount]);
+        } else {
+            t3d_skeleton_use(&mSkeleton);
+        }
+    }
+    if (mDisplayList) {
+        rspq_block_run(mDisplayList);
     }
-    CModel::draw();
 }
 
-void CSkinnedModel::createSkeleton()
+void CSkinnedModel::createSkeleton(int layerCount)
 {
     if (!mModel) return;
     
@@ -54,148 +140,580 @@ void CSkinnedModel::createSkeleton()
     
     mSkeleton = t3d_skeleton_create_buffered(mModel, mNumBuffers);
     mHasSkeleton = true;
+
+    if (layerCount < 1) layerCount = 1;
+    if (layerCount > ANIM_MAX_LAYERS) layerCount = ANIM_MAX_LAYERS;
+    mLayerCount = layerCount;
+
+    uint32_t boneCount = mSkeleton.skeletonRef->boneCount;
+    uint32_t layerBytes = boneCount * (sizeof(T3DVec3) * 2 + sizeof(T3DQuat) + sizeof(int32_t) + sizeof(uint8_t));
+    layerBytes = (layerBytes + 15) & ~15u;
+
+    if (mLayerCount > 1) {
+        mLayerPool = malloc(layerBytes * (mLayerCount - 1));
+        uint8_t* cursor = static_cast<uint8_t*>(mLayerPool);
+
+        for (int l = 1; l < mLayerCount; ++l) {
+            SAnimLayer& layer = mLayers[l];
+            layer.rotation = reinterpret_cast<T3DQuat*>(cursor);
+            layer.position = reinterpret_cast<T3DVec3*>(layer.rotation + boneCount);
+            layer.scale = layer.position + boneCount;
+            layer.changed = reinterpret_cast<int32_t*>(layer.scale + boneCount);
+            layer.mask = reinterpret_cast<uint8_t*>(layer.changed + boneCount);
+            cursor += layerBytes;
+
+            for (uint32_t b = 0; b < boneCount; ++b) {
+                layer.rotation[b] = mSkeleton.bones[b].rotation;
+                layer.position[b] = mSkeleton.bones[b].position;
+                layer.scale[b] = mSkeleton.bones[b].scale;
+                layer.changed[b] = 0;
+                layer.mask[b] = 255;
+            }
+        }
+    }
     
-    mSkeletonBlend = t3d_skeleton_clone(&mSkeleton, false);
-    mHasBlendSkeleton = true;
-    
-    mSkeletonAction = t3d_skeleton_clone(&mSkeleton, false);
-    mHasActionSkeleton = true;
-    
-    mBufferedMatrices = static_cast<T3DMat4FP*>(malloc_uncached(sizeof(T3DMat4FP) * mNumBuffers));
+    mBufferedMatrices = allocMatrices(mNumBuffers, mBufferedInArena);
+    markDirty();
+
+    mAnimLodCounter = sAnimLodSeed++ % sAnimLodDivisors[ANIM_LOD_LEVELS - 1];
+    mAnimLodAccum = 0.0f;
 }
 
-void CSkinnedModel::addAnimation(std::string const& name, int skeletonType)
+TAnimHandle CSkinnedModel::addAnimation(std::string const& name, int layer)
 {
-    if (!mModel) return;
+    if (!mModel) return ANIM_HANDLE_INVALID;
 
-    auto existing = mAnimations.find(name);
-    if (existing != mAnimations.end()) {
-        t3d_anim_destroy(&existing->second);
-        mAnimations.erase(existing);
+    TAnimHandle handle = findAnimation(name);
+    if (handle != ANIM_HANDLE_INVALID) {
+        if (handle == mBakedHandle) {
+            freeBakedAnimation();
+        }
+        destroyAnimation(mAnimations[handle]);
+    } else {
+        if (mAnimationCount >= SKINNED_MODEL_MAX_ANIMATIONS) {
+            debugf("CSkinnedModel: too many animations, dropping %s\n", name.c_str());
+            return ANIM_HANDLE_INVALID;
+        }
+        handle = mAnimationCount++;
+        mAnimationNames[handle] = name;
     }
     
-    T3DAnim anim = t3d_anim_create(mModel, name.c_str());
+    if (mRig == ANIM_RIG_INVALID) {
+        mRig = CAnimClipLibrary::instance().acquireRig(mModel, mPath.c_str());
+    }
+
+    T3DAnim anim = CAnimClipLibrary::instance().createCursor(mRig, name.c_str(), mModel);
     
-    if (skeletonType == 1 && mHasBlendSkeleton) {
-        t3d_anim_attach(&anim, &mSkeletonBlend);
-    } else if (skeletonType == 2 && mHasActionSkeleton) {
-        t3d_anim_attach(&anim, &mSkeletonAction);
+    if (isValidLayer(layer)) {
+        SAnimLayer& target = mLayers[layer];
+        for (uint32_t b = 0; b < mSkeleton.skeletonRef->boneCount; ++b) {
+            t3d_anim_attach_pos(&anim, b, &target.position[b], &target.changed[b]);
+            t3d_anim_attach_rot(&anim, b, &target.rotation[b], &target.changed[b]);
+            t3d_anim_attach_scale(&anim, b, &target.scale[b], &target.changed[b]);
+        }
     } else if (mHasSkeleton) {
+        layer = 0;
         t3d_anim_attach(&anim, &mSkeleton);
     }
     
-    mAnimations[name] = anim;
+    mAnimations[handle] = anim;
+    mAnimationLayers[handle] = layer;
+    return handle;
 }
 
-void CSkinnedModel::playAnimation(std::string const& name)
+TAnimHandle CSkinnedModel::findAnimation(std::string const& name) const
 {
-    auto it = mAnimations.find(name);
-    if (it != mAnimations.end()) {
-        t3d_anim_set_playing(&it->second, true);
+    for (int i = 0; i < mAnimationCount; ++i) {
+        if (mAnimationNames[i] == name) {
+            return i;
+        }
     }
+    return ANIM_HANDLE_INVALID;
 }
 
-void CSkinnedModel::stopAnimation(std::string const& name)
+void CSkinnedModel::playAnimation(TAnimHandle handle)
 {
-    auto it = mAnimations.find(name);
-    if (it != mAnimations.end()) {
-        t3d_anim_set_playing(&it->second, false);
+    if (isValidAnimation(handle)) {
+        t3d_anim_set_playing(&mAnimations[handle], true);
     }
 }
 
-void CSkinnedModel::setAnimationSpeed(std::string const& name, float speed)
+void CSkinnedModel::stopAnimation(TAnimHandle handle)
 {
-    auto it = mAnimations.find(name);
-    if (it != mAnimations.end()) {
-        t3d_anim_set_speed(&it->second, speed);
+    if (isValidAnimation(handle)) {
+        t3d_anim_set_playing(&mAnimations[handle], false);
     }
 }
 
-void CSkinnedModel::setAnimationLooping(std::string const& name, bool loop)
+void CSkinnedModel::setAnimationSpeed(TAnimHandle handle, float speed)
 {
-    auto it = mAnimations.find(name);
-    if (it != mAnimations.end()) {
-        t3d_anim_set_looping(&it->second, loop);
+    if (isValidAnimation(handle)) {
+        t3d_anim_set_speed(&mAnimations[handle], speed);
     }
 }
 
-void CSkinnedModel::resetAnimation(std::string const& name)
+void CSkinnedModel::setAnimationLooping(TAnimHandle handle, bool loop)
 {
-    auto it = mAnimations.find(name);
-    if (it != mAnimations.end()) {
-        t3d_anim_set_time(&it->second, 0.0f);
+    if (isValidAnimation(handle)) {
+        t3d_anim_set_looping(&mAnimations[handle], loop);
     }
 }
 
-bool CSkinnedModel::isAnimationFinished(std::string const& name) const
+void CSkinnedModel::resetAnimation(TAnimHandle handle)
 {
-    auto it = mAnimations.find(name);
-    if (it != mAnimations.end()) {
-        const T3DAnim& anim = it->second;
+    if (isValidAnimation(handle)) {
+        t3d_anim_set_time(&mAnimations[handle], 0.0f);
+    }
+}
+
+bool CSkinnedModel::isAnimationFinished(TAnimHandle handle) const
+{
+    if (isValidAnimation(handle)) {
+        const T3DAnim& anim = mAnimations[handle];
         return !anim.isPlaying && !anim.isLooping;
     }
     return false;
 }
 
-bool CSkinnedModel::isAnimationPlaying(std::string const& name) const
+bool CSkinnedModel::isAnimationPlaying(TAnimHandle handle) const
 {
-    auto it = mAnimations.find(name);
-    if (it != mAnimations.end()) {
-        return it->second.isPlaying;
+    if (isValidAnimation(handle)) {
+        return mAnimations[handle].isPlaying;
     }
     return false;
 }
 
-void CSkinnedModel::updateAnimation(std::string const& name, float dt)
+void CSkinnedModel::updateAnimation(TAnimHandle handle, float dt)
 {
-    auto it = mAnimations.find(name);
-    if (it != mAnimations.end() && it->second.animRef != nullptr) {
-        if (it->second.animRef->duration > 0.0f && dt > 0.0f) {
-            if (dt > it->second.animRef->duration) {
-                dt = it->second.animRef->duration * 0.5f;
-            }
-            t3d_anim_update(&it->second, dt);
+    if (!isValidAnimation(handle)) return;
+
+    T3DAnim& anim = mAnimations[handle];
+    if (anim.animRef != nullptr && anim.animRef->duration > 0.0f && dt > 0.0f) {
+        if (dt > anim.animRef->duration) {
+            dt = anim.animRef->duration * 0.5f;
         }
+        float prevTime = anim.time;
+        t3d_anim_update(&anim, dt);
+        fireAnimationEvents(handle, prevTime, anim.time);
     }
 }
 
 void CSkinnedModel::updateAnimations(float dt)
 {
-    for (auto& [name, anim] : mAnimations) {
-        t3d_anim_update(&anim, dt);
+    if (mBakedPlayback) {
+        const T3DAnim& anim = mAnimations[mBakedHandle];
+        if (anim.isPlaying) {
+            float prevTime = mBakedTime;
+            mBakedTime = fmodf(mBakedTime + dt * anim.speed, mBakedClip.duration);
+            fireAnimationEvents(mBakedHandle, prevTime, mBakedTime);
+        }
+        return;
+    }
+
+    for (int i = 0; i < mAnimationCount; ++i) {
+        float prevTime = mAnimations[i].time;
+        t3d_anim_update(&mAnimations[i], dt);
+        fireAnimationEvents(i, prevTime, mAnimations[i].time);
+    }
+}
+
+int CSkinnedModel::findBones(const char* const* names, int count, int* outBones)
+{
+    int found = 0;
+    for (int i = 0; i < count; ++i) {
+        outBones[i] = mHasSkeleton ? t3d_skeleton_find_bone(&mSkeleton, names[i]) : -1;
+        if (outBones[i] >= 0) {
+            ++found;
+        } else {
+            debugf("CSkinnedModel: bone %s not found\n", names[i]);
+        }
+    }
+    return found;
+}
+
+TSocketHandle CSkinnedModel::addSocket(const char* boneName, const T3DMat4* offset)
+{
+    if (!mHasSkeleton || mSocketCount >= SKINNED_MODEL_MAX_SOCKETS) return SOCKET_HANDLE_INVALID;
+
+    int bone = t3d_skeleton_find_bone(&mSkeleton, boneName);
+    if (bone < 0) {
+        debugf("CSkinnedModel: socket bone %s not found\n", boneName);
+        return SOCKET_HANDLE_INVALID;
+    }
+
+    SBoneSocket& socket = mSockets[mSocketCount];
+    socket.bone = bone;
+    if (offset) {
+        socket.offset = *offset;
+    } else {
+        t3d_mat4_identity(&socket.offset);
+    }
+    t3d_mat4_identity(&socket.world);
+    return mSocketCount++;
+}
+
+void CSkinnedModel::updateSockets(const T3DMat4* modelMatrix)
+{
+    if (!mHasSkeleton || mSocketCount == 0) return;
+
+    T3DMat4 modelMat;
+    if (!modelMatrix) {
+        t3d_mat4_from_srt_euler(&modelMat,
+            (float[3]){mScale.x(), mScale.y(), mScale.z()},
+            (float[3]){mRotation.x(), -mRotation.y(), mRotation.z()},
+            (float[3]){mPosition.x(), mPosition.y(), mPosition.z()}
+        );
+        modelMatrix = &modelMat;
+    }
+
+    for (int i = 0; i < mSocketCount; ++i) {
+        SBoneSocket& socket = mSockets[i];
+        T3DMat4 boneWorld;
+        t3d_mat4_mul(&boneWorld, modelMatrix, &mSkeleton.bones[socket.bone].matrix);
+        t3d_mat4_mul(&socket.world, &boneWorld, &socket.offset);
+    }
+}
+
+const T3DMat4* CSkinnedModel::getSocketMatrix(TSocketHandle handle) const
+{
+    return isValidSocket(handle) ? &mSockets[handle].world : nullptr;
+}
+
+T3DVec3 CSkinnedModel::getSocketPosition(TSocketHandle handle) const
+{
+    if (!isValidSocket(handle)) {
+        return {{mPosition.x(), mPosition.y(), mPosition.z()}};
+    }
+    const T3DMat4& world = mSockets[handle].world;
+    return {{world.m[3][0], world.m[3][1], world.m[3][2]}};
+}
+
+void CSkinnedModel::setLayerWeight(int layer, float weight)
+{
+    if (isValidLayer(layer)) {
+        mLayers[layer].weight = weight;
     }
 }
 
-void CSkinnedModel::blendAnimations(std::string const& animA, std::string const& animB, float blendFactor)
+void CSkinnedModel::setLayerMask(int layer, const char* rootBone)
 {
-    if (!mHasSkeleton || !mHasBlendSkeleton) return;
-    t3d_skeleton_blend(&mSkeleton, &mSkeleton, &mSkeletonBlend, blendFactor);
+    if (!isValidLayer(layer)) return;
+
+    int root = t3d_skeleton_find_bone(&mSkeleton, rootBone);
+    if (root < 0) {
+        debugf("CSkinnedModel: mask bone %s not found\n", rootBone);
+        return;
+    }
+
+    SAnimLayer& target = mLayers[layer];
+    const T3DChunkSkeleton* skelRef = mSkeleton.skeletonRef;
+    for (uint32_t b = 0; b < skelRef->boneCount; ++b) {
+        uint16_t parent = skelRef->bones[b].parentIdx;
+        bool inMask = b == static_cast<uint32_t>(root) || (parent != ANIM_BONE_NO_PARENT && target.mask[parent] != 0);
+        target.mask[b] = inMask ? 255 : 0;
+    }
+    target.masked = true;
+}
+
+void CSkinnedModel::clearLayerMask(int layer)
+{
+    if (!isValidLayer(layer)) return;
+
+    SAnimLayer& target = mLayers[layer];
+    memset(target.mask, 255, mSkeleton.skeletonRef->boneCount);
+    target.masked = false;
+}
+
+void CSkinnedModel::blendLayers()
+{
+    if (!mHasSkeleton || mBakedPlayback) return;
+
+    uint32_t boneCount = mSkeleton.skeletonRef->boneCount;
+
+    for (int l = 1; l < mLayerCount; ++l) {
+        const SAnimLayer& layer = mLayers[l];
+        if (layer.weight <= 0.0f) continue;
+
+        for (uint32_t b = 0; b < boneCount; ++b) {
+            float w = layer.weight;
+            if (layer.masked) {
+                if (layer.mask[b] == 0) continue;
+                w *= layer.mask[b] * (1.0f / 255.0f);
+            }
+
+            T3DBone& bone = mSkeleton.bones[b];
+            for (int i = 0; i < 3; ++i) {
+                bone.position.v[i] += (layer.position[b].v[i] - bone.position.v[i]) * w;
+                bone.scale.v[i] += (layer.scale[b].v[i] - bone.scale.v[i]) * w;
+            }
+
+            const T3DQuat& q = layer.rotation[b];
+            float dot = bone.rotation.v[0] * q.v[0] + bone.rotation.v[1] * q.v[1] +
+                        bone.rotation.v[2] * q.v[2] + bone.rotation.v[3] * q.v[3];
+            float sign = dot < 0.0f ? -1.0f : 1.0f;
+            float lenSq = 0.0f;
+            for (int i = 0; i < 4; ++i) {
+                bone.rotation.v[i] += (q.v[i] * sign - bone.rotation.v[i]) * w;
+                lenSq += bone.rotation.v[i] * bone.rotation.v[i];
+            }
+            if (lenSq > 0.0f) {
+                float invLen = 1.0f / sqrtf(lenSq);
+                for (int i = 0; i < 4; ++i) {
+                    bone.rotation.v[i] *= invLen;
+                }
+            }
+
+            bone.hasChanged = 1;
+        }
+    }
 }
 
 void CSkinnedModel::updateSkeleton()
 {
-    if (mHasSkeleton) {
+    if (mHasSkeleton && !mBakedPlayback) {
         t3d_skeleton_update(&mSkeleton);
     }
 }
 
-void CSkinnedModel::blendAction(float weight)
+void CSkinnedModel::bindAnimationEvents(CAnimEventTrackSet const& tracks)
 {
-    if (!mHasSkeleton || !mHasActionSkeleton) return;
-    if (weight <= 0.0f) return;
-    
-    t3d_skeleton_blend(&mSkeleton, &mSkeleton, &mSkeletonAction, weight);
+    for (int i = 0; i < mAnimationCount; ++i) {
+        mAnimEventTracks[i] = tracks.findTrack(mAnimationNames[i].c_str(), mAnimEventCounts[i]);
+    }
+    mAnimEventQueue.clear();
+}
+
+void CSkinnedModel::fireAnimationEvents(TAnimHandle handle, float prevTime, float time)
+{
+    const SAnimEvent* events = mAnimEventTracks[handle];
+    if (events == nullptr || time == prevTime) return;
+
+    bool wrapped = time < prevTime;
+    for (uint16_t i = 0; i < mAnimEventCounts[handle]; ++i) {
+        float t = events[i].time;
+        bool crossed = wrapped ? (t > prevTime || t <= time) : (t > prevTime && t <= time);
+        if (crossed) {
+            mAnimEventQueue.push({handle, events[i].type, events[i].param});
+        }
+    }
 }
 
-float CSkinnedModel::getAnimationFrame(std::string const& name) const
+float CSkinnedModel::getAnimationFrame(TAnimHandle handle) const
 {
-    auto it = mAnimations.find(name);
-    if (it != mAnimations.end()) {
-        return it->second.time * 60.0f;
+    if (isValidAnimation(handle)) {
+        return mAnimations[handle].time * 60.0f;
     }
     return 0.0f;
 }
 
+bool CSkinnedModel::bakeAnimation(TAnimHandle handle, float rate)
+{
+    if (!isValidAnimation(handle) || !mHasSkeleton || rate <= 0.0f) return false;
+    if (mAnimationLayers[handle] != 0) return false;
+
+    T3DAnim& anim = mAnimations[handle];
+    if (anim.animRef == nullptr || !anim.isLooping || anim.animRef->duration <= 0.0f) return false;
+
+    freeBakedAnimation();
+
+    float duration = anim.animRef->duration;
+    uint32_t boneCount = mSkeleton.skeletonRef->boneCount;
+    uint32_t frameCount = static_cast<uint32_t>(ceilf(duration * rate));
+    if (frameCount == 0) frameCount = 1;
+    // keys are spaced evenly over the loop so the last one blends straight back into the first
+    float step = duration / frameCount;
+
+    // quantised keys live in cached RAM; only the per-buffer pose the RSP reads is uncached
+    uint32_t keyBytes = frameCount * boneCount * sizeof(SBakedBone);
+    uint32_t poseBytes = mNumBuffers * boneCount * sizeof(T3DMat4FP);
+    uint32_t bytes = keyBytes + poseBytes;
+
+    if (bytes > sAnimBakeClipBudget || sAnimBakeBytesUsed + bytes > sAnimBakeTotalBudget) {
+        debugf("CSkinnedModel: %s needs %lu bytes to bake, using live evaluation\n",
+               mAnimationNames[handle].c_str(), bytes);
+        return false;
+    }
+
+    SBakedBone* frames = static_cast<SBakedBone*>(malloc(keyBytes));
+    T3DMat4FP* pose = static_cast<T3DMat4FP*>(malloc_uncached(poseBytes));
+    if (!frames || !pose) {
+        free(frames);
+        if (pose) free_uncached(pose);
+        return false;
+    }
+
+    float maxOffset = 0.0f;
+    for (uint32_t f = 0; f < frameCount; ++f) {
+        t3d_anim_set_time(&anim, f * step);
+        t3d_anim_update(&anim, 0.0f);
+        t3d_skeleton_update(&mSkeleton);
+        for (uint32_t b = 0; b < boneCount; ++b) {
+            for (int i = 0; i < 3; ++i) {
+                maxOffset = TMath<float>::max(maxOffset, fabsf(mSkeleton.bones[b].matrix.m[3][i]));
+            }
+        }
+    }
+    float positionUnit = maxOffset > 0.0f ? maxOffset / 32767.0f : 1.0f;
+
+    for (uint32_t f = 0; f < frameCount; ++f) {
+        t3d_anim_set_time(&anim, f * step);
+        t3d_anim_update(&anim, 0.0f);
+        t3d_skeleton_update(&mSkeleton);
+        for (uint32_t b = 0; b < boneCount; ++b) {
+            packBakedBone(frames[f * boneCount + b], mSkeleton.bones[b].matrix, positionUnit);
+        }
+    }
+
+    t3d_anim_set_time(&anim, 0.0f);
+    t3d_anim_update(&anim, 0.0f);
+    t3d_skeleton_update(&mSkeleton);
+
+    mBakedClip.frames = frames;
+    mBakedClip.pose = pose;
+    mBakedClip.bytes = bytes;
+    mBakedClip.frameCount = frameCount;
+    mBakedClip.boneCount = boneCount;
+    mBakedClip.rate = frameCount / duration;
+    mBakedClip.duration = duration;
+    mBakedClip.positionUnit = positionUnit;
+    mBakedHandle = handle;
+    mBakedTime = 0.0f;
+    mBakedPoseFrame = UINT32_MAX;
+    sAnimBakeBytesUsed += bytes;
+    return true;
+}
+
+void CSkinnedModel::setBakedPlayback(bool enabled)
+{
+    if (mBakedHandle == ANIM_HANDLE_INVALID) enabled = false;
+    if (enabled == mBakedPlayback) return;
+
+    T3DAnim& anim = mAnimations[mBakedHandle];
+    if (enabled) {
+        mBakedTime = fmodf(anim.time, mBakedClip.duration);
+        mBakedPoseFrame = UINT32_MAX;
+    } else {
+        t3d_anim_set_time(&anim, mBakedTime);
+    }
+    mBakedPlayback = enabled;
+}
+
+void CSkinnedModel::destroyAnimation(T3DAnim& anim)
+{
+    CAnimClipLibrary::instance().destroyCursor(mRig, anim);
+}
+
+void CSkinnedModel::freeBakedAnimation()
+{
+    if (mBakedHandle == ANIM_HANDLE_INVALID) return;
+
+    if (mBakedPlayback) {
+        t3d_anim_set_time(&mAnimations[mBakedHandle], mBakedTime);
+        mBakedPlayback = false;
+    }
+    free(mBakedClip.frames);
+    free_uncached(mBakedClip.pose);
+    sAnimBakeBytesUsed -= mBakedClip.bytes;
+    mBakedClip = {};
+    mBakedHandle = ANIM_HANDLE_INVALID;
+}
+
+void CSkinnedModel::updateBakedPose()
+{
+    if (mBakedPoseFrame == mFrameIndex) return;
+    mBakedPoseFrame = mFrameIndex;
+
+    float t = mBakedTime * mBakedClip.rate;
+    uint32_t key = static_cast<uint32_t>(t);
+    float alpha = t - key;
+    uint32_t boneCount = mBakedClip.boneCount;
+    const SBakedBone* from = &mBakedClip.frames[(key % mBakedClip.frameCount) * boneCount];
+    const SBakedBone* to = &mBakedClip.frames[((key + 1) % mBakedClip.frameCount) * boneCount];
+    T3DMat4FP* pose = &mBakedClip.pose[(mFrameIndex % mNumBuffers) * boneCount];
+
+    for (uint32_t b = 0; b < boneCount; ++b) {
+        const SBakedBone& a = from[b];
+        const SBakedBone& c = to[b];
+
+        int32_t dot = a.rotation[0] * c.rotation[0] + a.rotation[1] * c.rotation[1] +
+                      a.rotation[2] * c.rotation[2] + a.rotation[3] * c.rotation[3];
+        float sign = dot < 0 ? -1.0f : 1.0f;
+        float rotation[4];
+        float lenSq = 0.0f;
+        for (int i = 0; i < 4; ++i) {
+            rotation[i] = a.rotation[i] + (c.rotation[i] * sign - a.rotation[i]) * alpha;
+            lenSq += rotation[i] * rotation[i];
+        }
+        float invLen = lenSq > 0.0f ? 1.0f / sqrtf(lenSq) : 0.0f;
+        for (int i = 0; i < 4; ++i) {
+            rotation[i] *= invLen;
+        }
+
+        float position[3];
+        float scale[3];
+        for (int i = 0; i < 3; ++i) {
+            position[i] = (a.position[i] + (c.position[i] - a.position[i]) * alpha) * mBakedClip.positionUnit;
+            scale[i] = (a.scale[i] + (c.scale[i] - a.scale[i]) * alpha) * (1.0f / ANIM_BAKE_SCALE_ONE);
+        }
+
+        T3DMat4 mat;
+        t3d_mat4_from_srt(&mat, scale, rotation, position);
+        t3d_mat4_to_fixed_3x4(&pose[b], &mat);
+    }
+}
+
+bool CSkinnedModel::stepAnimationLod(float dt, const CViewport* viewport, float& outDt)
+{
+    mAnimLodAccum = TMath<float>::min(mAnimLodAccum + dt, ANIM_LOD_MAX_STEP);
+    mAnimCulled = false;
+    int prevLevel = mAnimLodLevel;
+    mAnimLodLevel = 0;
+
+    if (viewport) {
+        TVec3F center;
+        float radius;
+        getBoundingSphere(center, radius);
+
+        if (!viewport->isSphereVisible(center, radius * ANIM_LOD_BOUNDS_PADDING)) {
+            mAnimCulled = true;
+            ++sAnimLodStats.culled;
+            return false;
+        }
+
+        TVec3F const& cam = viewport->getCameraPosition();
+        float dx = center.x() - cam.x();
+        float dy = center.y() - cam.y();
+        float dz = center.z() - cam.z();
+        float distSq = dx * dx + dy * dy + dz * dz;
+
+        if (distSq > mAnimLodFar * mAnimLodFar) {
+            mAnimLodLevel = 2;
+        } else if (distSq > mAnimLodNear * mAnimLodNear) {
+            mAnimLodLevel = 1;
+        }
+    }
+
+    if (mAnimLodLevel == 0) {
+        ++sAnimLodStats.full;
+    } else {
+        ++sAnimLodStats.reduced;
+    }
+
+    if (mAnimLodLevel != prevLevel) {
+        mAnimLodCounter %= sAnimLodDivisors[mAnimLodLevel];
+    }
+
+    if (++mAnimLodCounter < sAnimLodDivisors[mAnimLodLevel]) {
+        return false;
+    }
+
+    outDt = mAnimLodAccum;
+    mAnimLodAccum = 0.0f;
+    mAnimLodCounter = 0;
+    ++sAnimLodStats.skeletonUpdates;
+    return true;
+}
+
 void CSkinnedModel::buildSkinnedDisplayList()
 {
     if (mDisplayList) {
@@ -215,6 +733,8 @@ void CSkinnedModel::updateBufferedMatrix(uint32_t frameIndex)
     if (!mBufferedMatrices || mNumBuffers == 0) return;
     
     uint32_t bufferIdx = frameIndex % mNumBuffers;
+    uint32_t bufferBit = 1u << bufferIdx;
+    if (!(mBufferDirtyMask & bufferBit)) return;
     
     t3d_mat4fp_from_srt_euler(
         &mBufferedMatrices[bufferIdx],
@@ -222,6 +742,8 @@ void CSkinnedModel::updateBufferedMatrix(uint32_t frameIndex)
         (float[3]){mRotation.x(), -mRotation.y(), mRotation.z()},
         (float[3]){mPosition.x(), mPosition.y(), mPosition.z()}
     );
+    mBufferDirtyMask &= ~bufferBit;
+    ++sMatrixRebuilds;
 }
 
 void CSkinnedModel::setBufferedMatrixFromMat4(const T3DMat4* mat)
@@ -231,4 +753,6 @@ void CSkinnedModel::setBufferedMatrixFromMat4(const T3DMat4* mat)
     uint32_t bufferIdx = mFrameIndex % mNumBuffers;
     
     t3d_mat4_to_fixed(&mBufferedMatrices[bufferIdx], mat);
+    mBufferDirtyMask |= 1u << bufferIdx;
+    ++sMatrixRebuilds;
 }
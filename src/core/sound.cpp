@@ -1,5 +1,6 @@
 #include "sound.hpp"
 #include "wav64.h"
+#include "asset_cache.hpp"
 
 std::unordered_map<std::string, TSoundRes> CSoundMgr::sSoundResStrList{};
 std::unordered_map<int32_t, TSoundRes> CSoundMgr::sSoundResKeyList{};
@@ -56,8 +57,11 @@ void CSoundMgr::open(std::string const & res)
     TSoundRes soundRes{};
     std::string resFullPath = "rom:/" + res + ".wav64";
 
-    wav64_open(&soundRes.waveRes, resFullPath.c_str());
-	wav64_set_loop(&soundRes.waveRes, soundRes.isLoop);
+    CAssetCache& cache = CAssetCache::instance();
+    soundRes.waveRes = cache.getSound(cache.acquire(EAssetType::Sound, resFullPath.c_str()));
+    if (!soundRes.waveRes)
+        return;
+	wav64_set_loop(soundRes.waveRes, soundRes.isLoop);
 
     sSoundResStrList[res] = soundRes;
 }
@@ -84,9 +88,9 @@ void CSoundMgr::play(const std::string & res, bool loop, int32_t channel)
     }
 
     it->second.isLoop = loop;
-    wav64_set_loop(&it->second.waveRes, loop);
+    wav64_set_loop(it->second.waveRes, loop);
 
-	const bool stereo = it->second.waveRes.wave.channels == 2;
+	const bool stereo = it->second.waveRes->wave.channels == 2;
 
     int32_t mixerChannel = channel;
     const bool channelValid = (mixerChannel >= 0) && (mixerChannel < sMixerChannelCount);
@@ -101,7 +105,7 @@ void CSoundMgr::play(const std::string & res, bool loop, int32_t channel)
             mixerChannel = allocSfxChannel(true);
     }
 
-    wav64_play(&it->second.waveRes, mixerChannel);
+    wav64_play(it->second.waveRes, mixerChannel);
 }
 
 void CSoundMgr::stop(int32_t channel)
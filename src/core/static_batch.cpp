@@ -0,0 +1,166 @@
+#include "static_batch.hpp"
+#include "viewport.hpp"
+#include <cmath>
+#include <cstring>
+
+CStaticBatch::~CStaticBatch()
+{
+    clear();
+}
+
+bool CStaticBatch::add(CModel* model, const char* key)
+{
+    if (!model || !model->getModel() || !key) return false;
+
+    SGroup* group = findGroup(key);
+    if (!group) {
+        if (mGroupCount >= STATIC_BATCH_MAX_GROUPS) {
+            debugf("CStaticBatch: no free group for %s\n", key);
+            return false;
+        }
+        group = &mGroups[mGroupCount++];
+        group->key = key;
+        ++mStats.groups;
+    }
+
+    if (group->count >= STATIC_BATCH_MAX_INSTANCES) {
+        debugf("CStaticBatch: group %s is full\n", key);
+        return false;
+    }
+
+    group->instances[group->count++] = model;
+    ++mStats.instances;
+    return true;
+}
+
+bool CStaticBatch::remove(CModel* model)
+{
+    for (int g = 0; g < mGroupCount; ++g) {
+        SGroup& group = mGroups[g];
+        for (int i = 0; i < group.count; ++i) {
+            if (group.instances[i] != model) continue;
+
+            group.instances[i] = group.instances[--group.count];
+            group.instances[group.count] = nullptr;
+            --mStats.instances;
+
+            buildGroup(group);
+            return true;
+        }
+    }
+    return false;
+}
+
+void CStaticBatch::build()
+{
+    for (int g = 0; g < mGroupCount; ++g) {
+        buildGroup(mGroups[g]);
+    }
+}
+
+void CStaticBatch::clear()
+{
+    for (int g = 0; g < mGroupCount; ++g) {
+        freeGroup(mGroups[g]);
+        mGroups[g] = {};
+    }
+    mGroupCount = 0;
+    mStats = {};
+}
+
+void CStaticBatch::draw(const CViewport* viewport)
+{
+    mStats.drawn = 0;
+    mStats.culled = 0;
+
+    for (int g = 0; g < mGroupCount; ++g) {
+        const SGroup& group = mGroups[g];
+        if (!group.displayList) continue;
+
+        if (viewport && !viewport->isSphereVisible(group.boundsCenter, group.boundsRadius)) {
+            ++mStats.culled;
+            continue;
+        }
+
+        rspq_block_run(group.displayList);
+        ++mStats.drawn;
+    }
+}
+
+CStaticBatch::SGroup* CStaticBatch::findGroup(const char* key)
+{
+    for (int g = 0; g < mGroupCount; ++g) {
+        if (strcmp(mGroups[g].key, key) == 0) {
+            return &mGroups[g];
+        }
+    }
+    return nullptr;
+}
+
+void CStaticBatch::buildGroup(SGroup& group)
+{
+    freeGroup(group);
+    if (group.count == 0) return;
+
+    group.matrices = static_cast<T3DMat4FP*>(malloc_uncached(sizeof(T3DMat4FP) * group.count));
+
+    TVec3F lo{0.0f, 0.0f, 0.0f};
+    TVec3F hi{0.0f, 0.0f, 0.0f};
+    TVec3F centers[STATIC_BATCH_MAX_INSTANCES];
+    float radii[STATIC_BATCH_MAX_INSTANCES];
+
+    for (int i = 0; i < group.count; ++i) {
+        CModel* model = group.instances[i];
+        model->updateMatrix();
+        group.matrices[i] = *model->getMatrix();
+
+        model->getBoundingSphere(centers[i], radii[i]);
+        TVec3F cLo{centers[i].x() - radii[i], centers[i].y() - radii[i], centers[i].z() - radii[i]};
+        TVec3F cHi{centers[i].x() + radii[i], centers[i].y() + radii[i], centers[i].z() + radii[i]};
+        if (i == 0) {
+            lo = cLo;
+            hi = cHi;
+        } else {
+            lo = {TMath<float>::min(lo.x(), cLo.x()), TMath<float>::min(lo.y(), cLo.y()), TMath<float>::min(lo.z(), cLo.z())};
+            hi = {TMath<float>::max(hi.x(), cHi.x()), TMath<float>::max(hi.y(), cHi.y()), TMath<float>::max(hi.z(), cHi.z())};
+        }
+    }
+
+    group.boundsCenter = {(lo.x() + hi.x()) * 0.5f, (lo.y() + hi.y()) * 0.5f, (lo.z() + hi.z()) * 0.5f};
+    group.boundsRadius = 0.0f;
+    for (int i = 0; i < group.count; ++i) {
+        float dx = centers[i].x() - group.boundsCenter.x();
+        float dy = centers[i].y() - group.boundsCenter.y();
+        float dz = centers[i].z() - group.boundsCenter.z();
+        group.boundsRadius = TMath<float>::max(group.boundsRadius, sqrtf(dx * dx + dy * dy + dz * dz) + radii[i]);
+    }
+
+    T3DModel* source = group.instances[0]->getModel();
+    T3DModelState state = t3d_model_state_create();
+
+    rspq_block_begin();
+    rdpq_set_prim_color(RGBA32(255, 255, 255, 255));
+    T3DModelIter it = t3d_model_iter_create(source, T3D_CHUNK_TYPE_OBJECT);
+    while (t3d_model_iter_next(&it)) {
+        t3d_model_draw_material(it.object->material, &state);
+        for (int i = 0; i < group.count; ++i) {
+            t3d_matrix_push(&group.matrices[i]);
+            t3d_model_draw_object(it.object, nullptr);
+            t3d_matrix_pop(1);
+        }
+    }
+    group.displayList = rspq_block_end();
+}
+
+void CStaticBatch::freeGroup(SGroup& group)
+{
+    // deferred frees keep the previous frame's block and matrices alive until the RDP is done
+    if (group.displayList) {
+        rspq_block_free(group.displayList);
+        group.displayList = nullptr;
+    }
+    if (group.matrices) {
+        rdpq_call_deferred(free_uncached, group.matrices);
+        group.matrices = nullptr;
+    }
+}
@@ -11,6 +11,7 @@ void CViewport::setProjection(float fov, float nearPlane, float farPlane)
     mNear = nearPlane;
     mFar = farPlane;
     t3d_viewport_set_projection(&mViewport, T3D_DEG_TO_RAD(mFov), mNear, mFar);
+    updateFrustum();
 }
 
 void CViewport::lookAt(TVec3F const& camPos, TVec3F const& target)
@@ -19,9 +20,31 @@ void CViewport::lookAt(TVec3F const& camPos, TVec3F const& target)
     T3DVec3 tgt = {{target.x(), target.y(), target.z()}};
     T3DVec3 up = {{0.0f, 1.0f, 0.0f}};
     t3d_viewport_look_at(&mViewport, &pos, &tgt, &up);
+    mCameraPosition = camPos;
+    updateFrustum();
 }
 
 void CViewport::attach()
 {
     t3d_viewport_attach(&mViewport);
 }
+
+bool CViewport::isSphereVisible(TVec3F const& center, float radius) const
+{
+    T3DVec3 c = {{center.x(), center.y(), center.z()}};
+    return t3d_frustum_vs_sphere(&mFrustum, &c, radius);
+}
+
+bool CViewport::isAabbVisible(TVec3F const& min, TVec3F const& max) const
+{
+    T3DVec3 lo = {{min.x(), min.y(), min.z()}};
+    T3DVec3 hi = {{max.x(), max.y(), max.z()}};
+    return t3d_frustum_vs_aabb(&mFrustum, &lo, &hi);
+}
+
+void CViewport::updateFrustum()
+{
+    T3DMat4 camProj;
+    t3d_mat4_mul(&camProj, &mViewport.matProj, &mViewport.matCamera);
+    t3d_mat4_to_frustum(&mFrustum, &camProj);
+}
@@ -1,4 +1,5 @@
 #include "wipe.hpp"
+#include "asset_cache.hpp"
 #include <math.h>
 #include <string.h>
 
@@ -73,7 +74,7 @@ void CCircleWipe::init()
     mRadius = mMaxRadius;
     mTargetRadius = mMaxRadius;
     
-    mSprite = sprite_load("rom:/circle_mask.sprite");
+    mSprite = CAssetCache::instance().acquireSprite("rom:/circle_mask.sprite");
     
     mInitialized = true;
 }
@@ -81,7 +82,8 @@ void CCircleWipe::init()
 void CCircleWipe::destroy()
 {
     if (mInitialized) {
-        sprite_free(mSprite);
+        CAssetCache::instance().releaseData(mSprite);
+        mSprite = nullptr;
         mInitialized = false;
     }
 }
@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+
+import struct
+import sys
+import json
+import argparse
+from pathlib import Path
+
+
+NAME_LENGTH = 24
+
+DEFAULT_FPS = 60.0
+
+EVENT_TYPE_MAP = {
+    'footstep': 0,
+    'throw_release': 1,
+    'reel_click': 2,
+}
+
+
+def write_aevt_binary(tracks: dict, output_path: str, verbose: bool):
+    fps = float(tracks.get('fps', DEFAULT_FPS))
+    clips = tracks.get('clips', {})
+
+    clip_entries = []
+    events = []
+
+    for name, clip in clips.items():
+        encoded = name.encode('ascii')
+        if len(encoded) >= NAME_LENGTH:
+            print(f"Error: Clip name too long '{name}'")
+            sys.exit(1)
+
+        clip_fps = float(clip.get('fps', fps))
+        clip_events = []
+        for event in clip.get('events', []):
+            type_name = event.get('type', '').lower()
+            if type_name not in EVENT_TYPE_MAP:
+                print(f"Error: Unknown event type '{type_name}' in clip '{name}'")
+                sys.exit(1)
+
+            if 'time' in event:
+                time = float(event['time'])
+            else:
+                time = float(event.get('frame', 0)) / clip_fps
+
+            clip_events.append((time, EVENT_TYPE_MAP[type_name], int(event.get('param', 0))))
+
+        clip_events.sort(key=lambda e: e[0])
+        clip_entries.append((encoded, len(events), len(clip_events)))
+        events.extend(clip_events)
+
+        if verbose:
+            print(f"  {name}: {[(round(t, 3), ty, p) for t, ty, p in clip_events]}")
+
+    with open(output_path, 'wb') as f:
+        f.write(b'AEVT')
+
+        f.write(struct.pack('>H', 1))
+
+        f.write(struct.pack('>H', len(clip_entries)))
+
+        for encoded, first, count in clip_entries:
+            f.write(encoded.ljust(NAME_LENGTH, b'\0'))
+            f.write(struct.pack('>HH', first, count))
+
+        for time, type_id, param in events:
+            f.write(struct.pack('>fBBH', time, type_id, param & 0xFF, 0))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Convert animation event track JSON to N64 animation event binary format',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  python aevt_convert.py snep.json snep.aevt
+
+Event types: footstep, throw_release, reel_click
+"""
+    )
+    parser.add_argument('input', help='Input event track definition (.json)')
+    parser.add_argument('output', help='Output event track file (.aevt)')
+    parser.add_argument('--verbose', '-v', action='store_true',
+                        help='Print detailed information')
+
+    args = parser.parse_args()
+
+    input_path = Path(args.input)
+    if not input_path.exists():
+        print(f"Error: Input file not found: {args.input}")
+        sys.exit(1)
+
+    with open(input_path, 'r') as f:
+        tracks = json.load(f)
+
+    if args.verbose:
+        print(f"Loading: {args.input}")
+
+    write_aevt_binary(tracks, args.output, args.verbose)
+
+    print(f"Wrote animation events to {args.output}")
+
+
+if __name__ == '__main__':
+    main()
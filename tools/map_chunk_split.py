@@ -0,0 +1,294 @@
+#!/usr/bin/env python3
+
+import sys
+import argparse
+from pathlib import Path
+
+try:
+    from pygltflib import GLTF2, Scene, Node, Mesh, Primitive, Attributes, Accessor, BufferView, Buffer
+    import numpy as np
+except ImportError:
+    print("Error: Required packages not found. Install with:")
+    print("  pip install pygltflib numpy")
+    sys.exit(1)
+
+
+DEFAULT_CHUNK_SIZE = 4.0
+
+MODE_TRIANGLES = 4
+
+COMPONENT_TYPES = {
+    5120: np.int8,
+    5121: np.uint8,
+    5122: np.int16,
+    5123: np.uint16,
+    5125: np.uint32,
+    5126: np.float32,
+}
+
+TYPE_COUNTS = {
+    'SCALAR': 1,
+    'VEC2': 2,
+    'VEC3': 3,
+    'VEC4': 4,
+}
+
+COUNT_TYPES = {v: k for k, v in TYPE_COUNTS.items()}
+
+TARGET_ARRAY_BUFFER = 34962
+TARGET_ELEMENT_ARRAY_BUFFER = 34963
+
+
+def get_buffer_data(gltf: GLTF2, buffer_index: int) -> bytes:
+    buffer = gltf.buffers[buffer_index]
+    if buffer.uri is None:
+        return gltf.binary_blob()
+    if buffer.uri.startswith('data:'):
+        import base64
+        return base64.b64decode(buffer.uri.split(',')[1])
+    with open(Path(gltf._path).parent / buffer.uri, 'rb') as f:
+        return f.read()
+
+
+def get_buffer_view_data(gltf: GLTF2, view_index: int) -> bytes:
+    view = gltf.bufferViews[view_index]
+    data = get_buffer_data(gltf, view.buffer)
+    offset = view.byteOffset or 0
+    return data[offset:offset + view.byteLength]
+
+
+def get_accessor_data(gltf: GLTF2, accessor_index: int) -> np.ndarray:
+    accessor = gltf.accessors[accessor_index]
+    view = gltf.bufferViews[accessor.bufferView]
+    data = get_buffer_data(gltf, view.buffer)
+
+    dtype = np.dtype(COMPONENT_TYPES[accessor.componentType])
+    count = TYPE_COUNTS[accessor.type]
+    stride = view.byteStride or dtype.itemsize * count
+    offset = (view.byteOffset or 0) + (accessor.byteOffset or 0)
+
+    rows = []
+    for i in range(accessor.count):
+        start = offset + i * stride
+        rows.append(np.frombuffer(data, dtype=dtype, count=count, offset=start))
+    arr = np.array(rows, dtype=dtype).reshape((accessor.count, count))
+
+    if accessor.normalized and dtype.kind in 'iu':
+        arr = arr.astype(np.float32) / float(np.iinfo(dtype).max)
+
+    return arr if count > 1 else arr.reshape(-1)
+
+
+def get_node_transform(node) -> np.ndarray:
+    if node.matrix is not None:
+        return np.array(node.matrix, dtype=np.float64).reshape((4, 4)).T
+
+    mat = np.eye(4)
+    if node.scale is not None:
+        mat = np.diag([node.scale[0], node.scale[1], node.scale[2], 1.0]) @ mat
+    if node.rotation is not None:
+        qx, qy, qz, qw = node.rotation
+        r = np.array([
+            [1-2*(qy*qy+qz*qz), 2*(qx*qy-qz*qw), 2*(qx*qz+qy*qw), 0],
+            [2*(qx*qy+qz*qw), 1-2*(qx*qx+qz*qz), 2*(qy*qz-qx*qw), 0],
+            [2*(qx*qz-qy*qw), 2*(qy*qz+qx*qw), 1-2*(qx*qx+qy*qy), 0],
+            [0, 0, 0, 1]
+        ])
+        mat = r @ mat
+    if node.translation is not None:
+        t = np.eye(4)
+        t[:3, 3] = node.translation
+        mat = t @ mat
+    return mat
+
+
+def collect_mesh_instances(gltf: GLTF2) -> list:
+    parents = {}
+    for node_idx, node in enumerate(gltf.nodes):
+        for child in node.children or []:
+            parents[child] = node_idx
+
+    def world_transform(node_idx):
+        local = get_node_transform(gltf.nodes[node_idx])
+        parent = parents.get(node_idx)
+        return world_transform(parent) @ local if parent is not None else local
+
+    instances = []
+    for node_idx, node in enumerate(gltf.nodes):
+        if node.mesh is not None:
+            instances.append((node.mesh, world_transform(node_idx)))
+    return instances
+
+
+def extract_primitives(gltf: GLTF2) -> list:
+    primitives = []
+    for mesh_idx, transform in collect_mesh_instances(gltf):
+        normal_matrix = np.linalg.inv(transform[:3, :3]).T
+        for prim in gltf.meshes[mesh_idx].primitives:
+            if (prim.mode or MODE_TRIANGLES) != MODE_TRIANGLES:
+                continue
+
+            attributes = {}
+            for name, accessor_index in vars(prim.attributes).items():
+                if accessor_index is None or name.startswith(('JOINTS', 'WEIGHTS')):
+                    continue
+                attributes[name] = get_accessor_data(gltf, accessor_index).astype(np.float32)
+
+            positions = attributes['POSITION'].astype(np.float64)
+            positions = positions @ transform[:3, :3].T + transform[:3, 3]
+            attributes['POSITION'] = positions.astype(np.float32)
+
+            if 'NORMAL' in attributes:
+                normals = attributes['NORMAL'].astype(np.float64) @ normal_matrix.T
+                lengths = np.linalg.norm(normals, axis=1, keepdims=True)
+                attributes['NORMAL'] = (normals / np.maximum(lengths, 1e-6)).astype(np.float32)
+
+            if prim.indices is not None:
+                indices = get_accessor_data(gltf, prim.indices).astype(np.uint32)
+            else:
+                indices = np.arange(len(positions), dtype=np.uint32)
+
+            primitives.append((prim.material, attributes, indices.reshape((-1, 3))))
+    return primitives
+
+
+def split_into_chunks(primitives: list, chunk_size: float) -> tuple:
+    all_positions = np.concatenate([attrs['POSITION'] for _, attrs, _ in primitives])
+    origin = all_positions.min(axis=0)
+
+    chunks = {}
+    for material, attributes, triangles in primitives:
+        centroids = attributes['POSITION'][triangles].mean(axis=1)
+        cols = np.floor((centroids[:, 0] - origin[0]) / chunk_size).astype(int)
+        rows = np.floor((centroids[:, 2] - origin[2]) / chunk_size).astype(int)
+
+        for cell in set(zip(cols.tolist(), rows.tolist())):
+            mask = (cols == cell[0]) & (rows == cell[1])
+            cell_tris = triangles[mask]
+            used, remap = np.unique(cell_tris, return_inverse=True)
+            cell_attrs = {name: data[used] for name, data in attributes.items()}
+            chunks.setdefault(cell, []).append((material, cell_attrs, remap.reshape((-1, 3)).astype(np.uint32)))
+
+    return chunks, origin
+
+
+class BlobWriter:
+    def __init__(self, gltf: GLTF2):
+        self.gltf = gltf
+        self.blob = bytearray()
+
+    def add_view(self, data: bytes, target=None) -> int:
+        while len(self.blob) % 4:
+            self.blob.append(0)
+        self.gltf.bufferViews.append(BufferView(buffer=0, byteOffset=len(self.blob), byteLength=len(data), target=target))
+        self.blob.extend(data)
+        return len(self.gltf.bufferViews) - 1
+
+    def add_accessor(self, arr: np.ndarray, target: int, with_bounds: bool = False) -> int:
+        count = 1 if arr.ndim == 1 else arr.shape[1]
+        component = 5126 if arr.dtype == np.float32 else (5123 if arr.dtype == np.uint16 else 5125)
+        view = self.add_view(np.ascontiguousarray(arr).tobytes(), target)
+        accessor = Accessor(bufferView=view, componentType=component, count=len(arr), type=COUNT_TYPES[count])
+        if with_bounds:
+            accessor.min = arr.min(axis=0).tolist()
+            accessor.max = arr.max(axis=0).tolist()
+        self.gltf.accessors.append(accessor)
+        return len(self.gltf.accessors) - 1
+
+
+def write_chunked_gltf(source: GLTF2, chunks: dict, output_path: str, verbose: bool):
+    out = GLTF2()
+    out.asset = source.asset
+    out.samplers = source.samplers
+    out.textures = source.textures
+    out.materials = source.materials
+    out.buffers = [Buffer()]
+    writer = BlobWriter(out)
+
+    for image in source.images:
+        if image.bufferView is not None:
+            image.bufferView = writer.add_view(get_buffer_view_data(source, image.bufferView))
+        out.images.append(image)
+
+    nodes = []
+    for (col, row), parts in sorted(chunks.items(), key=lambda c: (c[0][1], c[0][0])):
+        name = f"chunk_{col}_{row}"
+        primitives = []
+        tri_count = 0
+        for material, attributes, triangles in parts:
+            prim_attrs = Attributes()
+            for attr_name, data in attributes.items():
+                setattr(prim_attrs, attr_name, writer.add_accessor(data, TARGET_ARRAY_BUFFER, attr_name == 'POSITION'))
+
+            index_type = np.uint16 if len(attributes['POSITION']) <= 0xFFFF else np.uint32
+            indices = writer.add_accessor(triangles.reshape(-1).astype(index_type), TARGET_ELEMENT_ARRAY_BUFFER)
+            primitives.append(Primitive(attributes=prim_attrs, indices=indices, material=material, mode=MODE_TRIANGLES))
+            tri_count += len(triangles)
+
+        out.meshes.append(Mesh(name=name, primitives=primitives))
+        out.nodes.append(Node(name=name, mesh=len(out.meshes) - 1))
+        nodes.append(len(out.nodes) - 1)
+
+        if verbose:
+            print(f"  {name}: {len(primitives)} primitives, {tri_count} triangles")
+
+    out.buffers[0].byteLength = len(writer.blob)
+    out.scenes = [Scene(nodes=nodes)]
+    out.scene = 0
+    out.set_binary_blob(bytes(writer.blob))
+    out.save_binary(output_path)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Split a map glTF into spatial chunks, one mesh object per grid cell',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  python map_chunk_split.py village.glb village_chunks.glb
+  python map_chunk_split.py --size 3 -v village.glb village_chunks.glb
+
+Each occupied cell becomes a mesh/node named chunk_<col>_<row>. Triangles are
+assigned to the cell containing their centroid on the XZ plane. Sizes are in
+raw glTF units, before the 64x scale applied by the tiny3d importer.
+"""
+    )
+    parser.add_argument('input', help='Input map glTF/glb file')
+    parser.add_argument('output', help='Output chunked glb file')
+    parser.add_argument('--size', type=float, default=DEFAULT_CHUNK_SIZE,
+                        help=f'Chunk edge length in glTF units (default: {DEFAULT_CHUNK_SIZE})')
+    parser.add_argument('--verbose', '-v', action='store_true',
+                        help='Print detailed information')
+
+    args = parser.parse_args()
+
+    input_path = Path(args.input)
+    if not input_path.exists():
+        print(f"Error: Input file not found: {args.input}")
+        sys.exit(1)
+
+    if args.size <= 0.0:
+        print("Error: Chunk size must be positive")
+        sys.exit(1)
+
+    if args.verbose:
+        print(f"Loading: {args.input}")
+
+    source = GLTF2().load(str(input_path))
+    primitives = extract_primitives(source)
+    if not primitives:
+        print(f"Error: No triangle meshes in {args.input}")
+        sys.exit(1)
+
+    chunks, origin = split_into_chunks(primitives, args.size)
+
+    if args.verbose:
+        print(f"  Origin: ({origin[0]:.1f}, {origin[2]:.1f}), chunk size {args.size}")
+
+    write_chunked_gltf(source, chunks, args.output, args.verbose)
+
+    print(f"Wrote {len(chunks)} map chunks to {args.output}")
+
+
+if __name__ == '__main__':
+    main()
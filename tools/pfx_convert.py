@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+
+import struct
+import sys
+import json
+import argparse
+from pathlib import Path
+
+
+PFX_FLAG_CONTINUOUS = 0x0001
+
+LUT_SIZE = 16
+
+SIZE_LUT_SCALE = 64.0
+
+SPAWN_SHAPE_MAP = {
+    'point': 0,
+    'sphere': 1,
+    'box': 2,
+}
+
+RENDER_STATE_MAP = {
+    'opaque': 0,
+    'alpha': 1,
+}
+
+
+def clamp(value, lo, hi):
+    return max(lo, min(hi, value))
+
+
+def sample_curve(keys, t, default):
+    if not keys:
+        return default
+
+    keys = sorted(keys, key=lambda k: k[0])
+
+    if t <= keys[0][0]:
+        return keys[0][1]
+    if t >= keys[-1][0]:
+        return keys[-1][1]
+
+    for (t0, v0), (t1, v1) in zip(keys, keys[1:]):
+        if t0 <= t <= t1:
+            f = 0.0 if t1 == t0 else (t - t0) / (t1 - t0)
+            if isinstance(v0, list):
+                return [a + (b - a) * f for a, b in zip(v0, v1)]
+            return v0 + (v1 - v0) * f
+
+    return keys[-1][1]
+
+
+def build_luts(effect: dict):
+    color_keys = effect.get('color', {}).get('curve', [])
+    alpha_keys = effect.get('alpha', {}).get('curve', [])
+    size_keys = effect.get('size', {}).get('curve', [])
+
+    color_lut = []
+    size_lut = []
+
+    for i in range(LUT_SIZE):
+        t = i / (LUT_SIZE - 1)
+
+        rgb = sample_curve(color_keys, t, [255, 255, 255])
+        alpha = sample_curve(alpha_keys, t, 255)
+        color_lut.append([int(round(clamp(c, 0, 255))) for c in rgb[:3]] +
+                         [int(round(clamp(alpha, 0, 255)))])
+
+        scale = sample_curve(size_keys, t, 1.0)
+        size_lut.append(int(round(clamp(scale * SIZE_LUT_SCALE, 0, 255))))
+
+    return color_lut, size_lut
+
+
+def vec3(value, default):
+    if value is None:
+        return default
+    if isinstance(value, (int, float)):
+        return [float(value)] * 3
+    return [float(v) for v in value]
+
+
+def write_pfx_binary(effect: dict, output_path: str, verbose: bool):
+    emission = effect.get('emission', {})
+    shape = effect.get('shape', {})
+    velocity = effect.get('velocity', {})
+    size = effect.get('size', {})
+    life = effect.get('life', {})
+    color = effect.get('color', {})
+
+    flags = PFX_FLAG_CONTINUOUS if emission.get('continuous', False) else 0
+
+    shape_name = shape.get('type', 'point').lower()
+    if shape_name not in SPAWN_SHAPE_MAP:
+        print(f"Error: Unknown spawn shape '{shape_name}'")
+        sys.exit(1)
+
+    render_name = effect.get('renderState', 'opaque').lower()
+    if render_name not in RENDER_STATE_MAP:
+        print(f"Error: Unknown render state '{render_name}'")
+        sys.exit(1)
+
+    spawn_color = color.get('base', [255, 255, 255, 255])
+    if len(spawn_color) == 3:
+        spawn_color = spawn_color + [255]
+
+    color_lut, size_lut = build_luts(effect)
+
+    with open(output_path, 'wb') as f:
+        f.write(b'PFX1')
+
+        f.write(struct.pack('>H', 1))
+
+        f.write(struct.pack('>H', flags))
+
+        f.write(struct.pack('>H', int(effect.get('maxParticles', 64))))
+
+        f.write(struct.pack('>H', int(emission.get('burst', 0))))
+
+        f.write(struct.pack('>B', SPAWN_SHAPE_MAP[shape_name]))
+
+        f.write(struct.pack('>B', RENDER_STATE_MAP[render_name]))
+
+        f.write(struct.pack('>H', 0))
+
+        f.write(struct.pack('>f', float(emission.get('rate', 0.0))))
+
+        for v in vec3(shape.get('extent'), [0.0, 0.0, 0.0]):
+            f.write(struct.pack('>f', v))
+
+        for v in vec3(velocity.get('min'), [0.0, 0.0, 0.0]):
+            f.write(struct.pack('>f', v))
+
+        for v in vec3(velocity.get('max'), [0.0, 0.0, 0.0]):
+            f.write(struct.pack('>f', v))
+
+        for v in vec3(effect.get('gravity'), [0.0, -9.8, 0.0]):
+            f.write(struct.pack('>f', v))
+
+        f.write(struct.pack('>ff', float(size.get('min', 1.0)), float(size.get('max', 1.0))))
+
+        f.write(struct.pack('>ff', float(life.get('min', 1.0)), float(life.get('max', 1.0))))
+
+        f.write(struct.pack('>f', float(effect.get('worldScale', 1.0))))
+
+        for c in spawn_color[:4]:
+            f.write(struct.pack('>B', int(clamp(c, 0, 255))))
+
+        for entry in color_lut:
+            for c in entry:
+                f.write(struct.pack('>B', c))
+
+        for s in size_lut:
+            f.write(struct.pack('>B', s))
+
+    if verbose:
+        print(f"  Shape: {shape_name}, render: {render_name}, flags: 0x{flags:04x}")
+        print(f"  Color LUT: {color_lut}")
+        print(f"  Size LUT: {[s / SIZE_LUT_SCALE for s in size_lut]}")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Convert particle effect JSON to N64 particle effect binary format',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  python pfx_convert.py snow.json snow.pfx
+
+Spawn shapes: point, sphere, box
+Render states: opaque, alpha
+"""
+    )
+    parser.add_argument('input', help='Input effect definition (.json)')
+    parser.add_argument('output', help='Output effect file (.pfx)')
+    parser.add_argument('--verbose', '-v', action='store_true',
+                        help='Print detailed information')
+
+    args = parser.parse_args()
+
+    input_path = Path(args.input)
+    if not input_path.exists():
+        print(f"Error: Input file not found: {args.input}")
+        sys.exit(1)
+
+    with open(input_path, 'r') as f:
+        effect = json.load(f)
+
+    if args.verbose:
+        print(f"Loading: {args.input}")
+
+    write_pfx_binary(effect, args.output, args.verbose)
+
+    print(f"Wrote particle effect to {args.output}")
+
+
+if __name__ == '__main__':
+    main()